@@ -0,0 +1,162 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <string>
+#include <iostream>
+#include <unistd.h>
+#include <stdsc/stdsc_log.hpp>
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_share/fts_concurrent_mapqueue.hpp>
+#include <fts_cs/fts_cs_scheduler.hpp>
+
+struct Option
+{
+    uint32_t max_threads = 64;
+    uint32_t ops_per_thread = 100000;
+};
+
+void init(Option& option, int argc, char* argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "t:n:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                option.max_threads = std::stol(optarg);
+                break;
+            case 'n':
+                option.ops_per_thread = std::stol(optarg);
+                break;
+            case 'h':
+            default:
+                printf("Usage: %s [-t max_threads] [-n ops_per_thread]\n", argv[0]);
+                exit(1);
+        }
+    }
+}
+
+/**
+ * Adapter of the queue of calculation stages, which is taken in the order
+ * decided by the scheduling policy.
+ */
+template <fts_cs::SchedPolicy_t Policy>
+struct ScheduledQueueAdapter
+{
+    ScheduledQueueAdapter() : que(Policy) {}
+
+    void push(const int32_t key, const int32_t val)
+    {
+        fts_cs::SchedEntry entry;
+        entry.query_id = key;
+        entry.key_id   = key % 16;
+        que.push(entry, val);
+    }
+
+    bool pop(int32_t& key, int32_t& val)
+    {
+        fts_cs::SchedEntry entry;
+        if (!que.wait_pop(entry, val, 0)) {
+            return false;
+        }
+        key = entry.query_id;
+        return true;
+    }
+
+    fts_cs::ScheduledQueue<int32_t> que;
+};
+
+/**
+ * Each thread pushes elements of its own keys and pops any element,
+ * so that all threads are producers and consumers at the same time.
+ * @return throughput (ops/sec)
+ */
+template <class Queue>
+double measure(const uint32_t nthreads, const uint32_t ops_per_thread)
+{
+    Queue que;
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+
+    for (uint32_t t=0; t<nthreads; ++t) {
+        threads.emplace_back([&que, &go, t, ops_per_thread]() {
+            while (!go) {
+                std::this_thread::yield();
+            }
+            int32_t key, val;
+            for (uint32_t i=0; i<ops_per_thread; ++i) {
+                que.push(static_cast<int32_t>(t * ops_per_thread + i), i);
+                que.pop(key, val);
+            }
+        });
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& th : threads) {
+        th.join();
+    }
+    auto elapsed_sec = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_time).count();
+
+    // a push and a pop per iteration
+    return 2.0 * nthreads * ops_per_thread / elapsed_sec;
+}
+
+void exec(Option& option)
+{
+    using ShardedQueue = fts_share::ConcurrentMapQueue<int32_t, int32_t>;
+    using SingleLockQueue = fts_share::ConcurrentMapQueue<int32_t, int32_t, 1>;
+    using FIFOQueue = ScheduledQueueAdapter<fts_cs::kSchedPolicyFIFO>;
+    using FairQueue = ScheduledQueueAdapter<fts_cs::kSchedPolicyFair>;
+
+    printf("%8s %20s %20s %20s %20s\n", "threads", "sharded (Mops/s)", "single lock (Mops/s)",
+           "sched fifo (Mops/s)", "sched fair (Mops/s)");
+    for (uint32_t n=1; n<=option.max_threads; n*=2) {
+        double sharded = measure<ShardedQueue>(n, option.ops_per_thread);
+        double single  = measure<SingleLockQueue>(n, option.ops_per_thread);
+        double fifo    = measure<FIFOQueue>(n, option.ops_per_thread);
+        double fair    = measure<FairQueue>(n, option.ops_per_thread);
+        printf("%8u %20.2f %20.2f %20.2f %20.2f\n", n, sharded / 1e6, single / 1e6,
+               fifo / 1e6, fair / 1e6);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    STDSC_INIT_LOG();
+    try
+    {
+        Option option;
+        init(option, argc, argv);
+        exec(option);
+    }
+    catch (stdsc::AbstractException& e)
+    {
+        STDSC_LOG_ERR("Err: %s", e.what());
+    }
+    catch (...)
+    {
+        STDSC_LOG_ERR("Catch unknown exception");
+    }
+
+    return 0;
+}
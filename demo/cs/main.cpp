@@ -27,6 +27,8 @@
 #include <stdsc/stdsc_exception.hpp>
 #include <fts_share/fts_utility.hpp>
 #include <fts_share/fts_packet.hpp>
+#include <fts_share/fts_random.hpp>
+#include <fts_share/fts_taskpool.hpp>
 #include <fts_cs/fts_cs_srv.hpp>
 #include <fts_cs/fts_cs_state.hpp>
 #include <fts_cs/fts_cs_callback_param.hpp>
@@ -41,13 +43,25 @@ struct Option
     uint32_t max_queries = FTS_DEFAULT_MAX_CONCURRENT_QUERIES;
     uint32_t max_results = FTS_DEFAULT_MAX_RESULTS;
     uint32_t max_result_lifetime_sec = FTS_DEFAULT_MAX_RESULT_LIFETIME_SEC;
+    size_t max_result_bytes = FTS_DEFAULT_MAX_RESULT_BYTES;
+    fts_cs::EvalMode_t eval_mode = fts_cs::kEvalModeNTT;
+    int64_t packed_rows = FTS_DEFAULT_PACKED_ROWS;
+    fts_cs::SchedPolicy_t sched_policy = fts_cs::kSchedPolicyFair;
 };
 
+fts_cs::SchedPolicy_t parse_sched_policy(const std::string& name)
+{
+    if (name == "fifo") return fts_cs::kSchedPolicyFIFO;
+    if (name == "edf")  return fts_cs::kSchedPolicyEDF;
+    if (name == "cost") return fts_cs::kSchedPolicyCost;
+    return fts_cs::kSchedPolicyFair;
+}
+
 void init(Option& option, int argc, char* argv[])
 {
     int opt;
     opterr = 0;
-    while ((opt = getopt(argc, argv, "p:d:h")) != -1)
+    while ((opt = getopt(argc, argv, "p:d:m:e:b:t:o:s:h")) != -1)
     {
         switch (opt)
         {
@@ -66,9 +80,28 @@ void init(Option& option, int argc, char* argv[])
             case 'l':
                 option.max_result_lifetime_sec = std::stol(optarg);
                 break;
+            case 'm':
+                option.max_result_bytes = std::stoul(optarg);
+                break;
+            case 'e':
+                option.eval_mode = (std::string(optarg) == "normal")
+                    ? fts_cs::kEvalModeNormal : fts_cs::kEvalModeNTT;
+                break;
+            case 'b':
+                option.packed_rows = std::stol(optarg);
+                break;
+            case 't':
+                fts_share::TaskPool::set_shared_threads(std::stoul(optarg));
+                break;
+            case 'o':
+                option.sched_policy = parse_sched_policy(optarg);
+                break;
+            case 's':
+                fts_share::RandomGenerator::set_seed(std::stoull(optarg));
+                break;
             case 'h':
             default:
-                printf("Usage: %s [-p port] [-d lut_dir]\n", argv[0]);
+                printf("Usage: %s [-p port] [-d lut_dir] [-m max_result_bytes] [-e normal|ntt (ntt: one input only)] [-b packed_rows] [-t num_threads] [-o fair|fifo|edf|cost] [-s seed]\n", argv[0]);
                 exit(1);
         }
     }
@@ -87,6 +120,14 @@ void exec(Option& option)
         std::shared_ptr<stdsc::CallbackFunction> cb_result(
             new fts_cs::CallbackFunctionResultRequest());
         callback.set(fts_share::kControlCodeUpDownloadResult, cb_result);
+
+        std::shared_ptr<stdsc::CallbackFunction> cb_result_poll(
+            new fts_cs::CallbackFunctionResultPollRequest());
+        callback.set(fts_share::kControlCodeUpDownloadResultPoll, cb_result_poll);
+
+        std::shared_ptr<stdsc::CallbackFunction> cb_cancel(
+            new fts_cs::CallbackFunctionCancelRequest());
+        callback.set(fts_share::kControlCodeUpDownloadCancel, cb_cancel);
     }
 
     const std::string LUT_dirpath = option.lut_dir;
@@ -94,7 +135,12 @@ void exec(Option& option)
 
     std::shared_ptr<fts_cs::CSServer> cs_server
         (new fts_cs::CSServer(option.port.c_str(), dec_host, PORT_DEC_SRV, LUT_dirpath, callback, state,
-                              option.max_queries, option.max_results, option.max_result_lifetime_sec));
+                              option.max_queries, option.max_results, option.max_result_lifetime_sec,
+                              FTS_DEFAULT_MAX_CACHED_KEYS, FTS_DEFAULT_MAX_CACHED_KEY_BYTES,
+                              FTS_DEFAULT_MAX_LUT_BUNDLES, option.eval_mode,
+                              FTS_DEFAULT_MAX_QUERY_BYTES, option.packed_rows,
+                              fts_cs::CalcStageThreads(), option.sched_policy,
+                              option.max_result_bytes));
 
     cs_server->start();
     
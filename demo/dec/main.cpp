@@ -28,6 +28,7 @@
 #include <fts_share/fts_utility.hpp>
 #include <fts_share/fts_packet.hpp>
 #include <fts_share/fts_config.hpp>
+#include <fts_share/fts_taskpool.hpp>
 #include <fts_dec/fts_dec_srv.hpp>
 #include <fts_dec/fts_dec_state.hpp>
 #include <fts_dec/fts_dec_callback_param.hpp>
@@ -37,12 +38,14 @@ struct Option
 {
     std::string port = PORT_DEC_SRV;
     std::string config_filename; // set empty if file is specified
+    std::string key_image_dir;   // keys are held only in memory if empty
+    size_t zero_pool_depth = FTS_DEFAULT_ZERO_POOL_DEPTH;
 };
 
 void init(Option& option, int argc, char* argv[])
 {
     int opt;
-    while ((opt = getopt(argc, argv, "p:c:h")) != -1)
+    while ((opt = getopt(argc, argv, "p:c:k:z:t:h")) != -1)
     {
         switch (opt)
         {
@@ -52,9 +55,18 @@ void init(Option& option, int argc, char* argv[])
             case 'c':
                 option.config_filename = optarg;
                 break;
+            case 'k':
+                option.key_image_dir = optarg;
+                break;
+            case 'z':
+                option.zero_pool_depth = std::stoul(optarg);
+                break;
+            case 't':
+                fts_share::TaskPool::set_shared_threads(std::stoul(optarg));
+                break;
             case 'h':
             default:
-                printf("Usage: %s [-p port] [-c config_filename]\n", argv[0]);
+                printf("Usage: %s [-p port] [-c config_filename] [-k key_image_dir] [-z zero_pool_depth] [-t num_threads]\n", argv[0]);
                 exit(1);
         }
     }
@@ -84,6 +96,12 @@ void exec(Option& option)
         std::shared_ptr<stdsc::CallbackFunction> cb_midresult(
             new fts_dec::CallbackFunctionCsMidResult());
         callback.set(fts_share::kControlCodeUpDownloadCsMidResult, cb_midresult);
+        std::shared_ptr<stdsc::CallbackFunction> cb_ping(
+            new fts_dec::CallbackFunctionPingRequest());
+        callback.set(fts_share::kControlCodeRequestPing, cb_ping);
+        std::shared_ptr<stdsc::CallbackFunction> cb_key_check(
+            new fts_dec::CallbackFunctionKeyCheckRequest());
+        callback.set(fts_share::kControlCodeUpDownloadKeyCheck, cb_key_check);
     }
     fts_dec::CallbackParam param;
     if (fts_share::utility::file_exist(option.config_filename)) {
@@ -103,7 +121,8 @@ void exec(Option& option)
 #undef READ
     }
             
-    fts_dec::CommonCallbackParam cparam;
+    fts_dec::CommonCallbackParam cparam(option.key_image_dir, option.zero_pool_depth);
+    cparam.keycont.prepare_keys(param.param);
     callback.set_commondata(static_cast<void*>(&param), sizeof(param));
     callback.set_commondata(static_cast<void*>(&cparam), sizeof(cparam),
                             stdsc::CommonDataKind_t::kCommonDataOnAllConnection);
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_share/fts_taskpool.hpp>
+#include <fts_cs/fts_cs_accumulator.hpp>
+
+namespace fts_cs
+{
+
+void tree_sum(seal::Evaluator& evaluator,
+              std::vector<seal::Ciphertext>& terms,
+              seal::Ciphertext& result)
+{
+    STDSC_THROW_INVPARAM_IF_CHECK(!terms.empty(), "no ciphertexts to accumulate");
+    
+    const int64_t n = terms.size();
+    for (int64_t stride=1; stride<n; stride*=2) {
+        const int64_t npairs = (n - stride + 2 * stride - 1) / (2 * stride);
+        fts_share::TaskPool::shared().parallel_for(0, npairs, [&](int64_t p) {
+            const int64_t i = p * 2 * stride;
+            evaluator.add_inplace(terms[i], terms[i+stride]);
+        });
+    }
+
+    result = std::move(terms[0]);
+}
+
+void accumulate(seal::Evaluator& evaluator,
+                const seal::RelinKeys& relinkey,
+                std::vector<seal::Ciphertext>& terms,
+                seal::Ciphertext& result)
+{
+    tree_sum(evaluator, terms, result);
+    if (result.is_ntt_form()) {
+        evaluator.transform_from_ntt_inplace(result);
+    }
+    if (result.size() > 2) {
+        evaluator.relinearize_inplace(result, relinkey);
+    }
+}
+
+} /* namespace fts_cs */
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_ACCUMULATOR_HPP
+#define FTS_CS_ACCUMULATOR_HPP
+
+#include <vector>
+#include <seal/seal.h>
+
+namespace fts_cs
+{
+
+/**
+ * Sum up ciphertexts by parallel tree reduction without relinearization.
+ * @param[in] evaluator evaluator
+ * @param[in,out] terms ciphertexts to sum up (overwritten)
+ * @param[out] result   sum of ciphertexts
+ */
+void tree_sum(seal::Evaluator& evaluator,
+              std::vector<seal::Ciphertext>& terms,
+              seal::Ciphertext& result);
+
+/**
+ * Sum up ciphertexts by parallel tree reduction.
+ * The terms may be unrelinearized products (size 3) in NTT form or normal form.
+ * The result is transformed from NTT form if needed and relinearized once at the end.
+ * @param[in] evaluator evaluator
+ * @param[in] relinkey  relin keys
+ * @param[in,out] terms ciphertexts to sum up (overwritten)
+ * @param[out] result   sum of ciphertexts
+ */
+void accumulate(seal::Evaluator& evaluator,
+                const seal::RelinKeys& relinkey,
+                std::vector<seal::Ciphertext>& terms,
+                seal::Ciphertext& result);
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_ACCUMULATOR_HPP */
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <stdsc/stdsc_log.hpp>
+#include <fts_cs/fts_cs_admission.hpp>
+
+namespace fts_cs
+{
+
+struct AdmissionControl::Impl
+{
+    using Clock = std::chrono::steady_clock;
+    
+    Impl(const size_t max_bytes, const double max_cost)
+        : max_bytes_(max_bytes),
+          max_cost_(max_cost),
+          bytes_(0),
+          cost_(0),
+          num_queries_(0),
+          latency_msec_(FTS_DEFAULT_RETRY_AFTER_MSEC)
+    {}
+
+    void release(const size_t bytes, const double cost, const Clock::time_point& admitted)
+    {
+        const double msec = std::chrono::duration<double, std::milli>(Clock::now() - admitted).count();
+        std::lock_guard<std::mutex> lock(mutex_);
+        bytes_ -= bytes;
+        cost_ = num_queries_ > 1 ? cost_ - cost : 0;
+        --num_queries_;
+        // Moving average of the time from admission to the end.
+        latency_msec_ = 0.8 * latency_msec_ + 0.2 * msec;
+    }
+
+    static uint32_t clamp_msec(const double msec)
+    {
+        return static_cast<uint32_t>(std::min<double>(std::max<double>(msec, FTS_MIN_RETRY_AFTER_MSEC),
+                                                      FTS_MAX_RETRY_AFTER_MSEC));
+    }
+    
+    const size_t max_bytes_;
+    const double max_cost_;
+    size_t bytes_;
+    double cost_;
+    size_t num_queries_;
+    double latency_msec_;
+    mutable std::mutex mutex_;
+};
+
+AdmissionControl::AdmissionControl(const size_t max_bytes, const double max_cost)
+    : pimpl_(new Impl(max_bytes, max_cost))
+{}
+
+AdmissionControl::Ticket
+AdmissionControl::admit(const size_t bytes, const double cost, uint32_t& retry_after_msec)
+{
+    retry_after_msec = 0;
+    {
+        std::lock_guard<std::mutex> lock(pimpl_->mutex_);
+        const bool fits = (pimpl_->bytes_ + bytes <= pimpl_->max_bytes_ &&
+                           pimpl_->cost_ + cost <= pimpl_->max_cost_);
+        if (!fits && pimpl_->num_queries_ > 0) {
+            // Queries in flight end in parallel, so the excess over the limits
+            // is released in about the same fraction of their latency.
+            const double excess = std::max((pimpl_->bytes_ + bytes - static_cast<double>(pimpl_->max_bytes_)) / pimpl_->max_bytes_,
+                                           (pimpl_->cost_ + cost - pimpl_->max_cost_) / pimpl_->max_cost_);
+            retry_after_msec = Impl::clamp_msec(pimpl_->latency_msec_ * std::min(excess, 1.0));
+            STDSC_LOG_INFO("Rejected query by overload. (in flight: %lu bytes, cost %.0f, retry after: %u msec)",
+                           pimpl_->bytes_, pimpl_->cost_, retry_after_msec);
+            return nullptr;
+        }
+        pimpl_->bytes_ += bytes;
+        pimpl_->cost_  += cost;
+        ++pimpl_->num_queries_;
+    }
+
+    // The ticket keeps the state alive even if this is destroyed first.
+    auto impl = pimpl_;
+    const auto admitted = Impl::Clock::now();
+    return Ticket(impl.get(), [impl, bytes, cost, admitted](void*) {
+        impl->release(bytes, cost, admitted);
+    });
+}
+
+uint32_t AdmissionControl::retry_after_msec() const
+{
+    std::lock_guard<std::mutex> lock(pimpl_->mutex_);
+    return Impl::clamp_msec(pimpl_->latency_msec_ / std::max<size_t>(1, pimpl_->num_queries_));
+}
+
+size_t AdmissionControl::inflight_bytes() const
+{
+    std::lock_guard<std::mutex> lock(pimpl_->mutex_);
+    return pimpl_->bytes_;
+}
+
+double AdmissionControl::inflight_cost() const
+{
+    std::lock_guard<std::mutex> lock(pimpl_->mutex_);
+    return pimpl_->cost_;
+}
+
+} /* namespace fts_cs */
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_ADMISSION_HPP
+#define FTS_CS_ADMISSION_HPP
+
+#include <memory>
+#include <cstdint>
+#include <fts_share/fts_define.hpp>
+
+namespace fts_cs
+{
+
+/**
+ * @brief Provides admission control of queries by estimated memory and
+ *        work in flight. The admitted query holds the ticket until its
+ *        computation ends, and the reservation is released with the ticket.
+ *        A query is always admitted if no queries are in flight,
+ *        so that a query larger than the limits is not rejected forever.
+ */
+class AdmissionControl
+{
+public:
+    using Ticket = std::shared_ptr<void>;
+    
+    /**
+     * Constructor
+     * @param[in] max_bytes max estimated memory of queries in flight (bytes)
+     * @param[in] max_cost  max estimated work of queries in flight
+     */
+    AdmissionControl(const size_t max_bytes = FTS_DEFAULT_MAX_INFLIGHT_BYTES,
+                     const double max_cost = FTS_DEFAULT_MAX_INFLIGHT_COST);
+    virtual ~AdmissionControl(void) = default;
+
+    /**
+     * Admit query
+     * @param[in] bytes estimated memory of query (bytes)
+     * @param[in] cost  estimated work of query
+     * @param[out] retry_after_msec time to retry after if rejected (msec)
+     * @return ticket, or nullptr if rejected
+     */
+    Ticket admit(const size_t bytes, const double cost, uint32_t& retry_after_msec);
+
+    /**
+     * Get time to retry after when a query is rejected by other limits,
+     * which is the time until one of queries in flight ends.
+     * @return time (msec)
+     */
+    uint32_t retry_after_msec() const;
+
+    /**
+     * Get estimated memory of queries in flight
+     * @return memory (bytes)
+     */
+    size_t inflight_bytes() const;
+
+    /**
+     * Get estimated work of queries in flight
+     * @return work
+     */
+    double inflight_cost() const;
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> pimpl_;
+};
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_ADMISSION_HPP */
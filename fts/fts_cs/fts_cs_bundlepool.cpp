@@ -0,0 +1,394 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <stdsc/stdsc_log.hpp>
+#include <fts_share/fts_taskpool.hpp>
+#include <fts_share/fts_define.hpp>
+#include <fts_share/fts_random.hpp>
+#include <fts_cs/fts_cs_lutgeometry.hpp>
+#include <fts_cs/fts_cs_bundlepool.hpp>
+
+namespace fts_cs
+{
+
+#define BUNDLEPOOL_MAX_PARAMS (4)
+
+/**
+ * Returns the vector whose first 'num' elements are random permutation of [0, num)
+ * and the remaining elements are [num, total) in order.
+ */
+static std::vector<int64_t> get_randomvector(fts_share::RandomGenerator& rng,
+                                             int64_t num, int64_t total)
+{
+    std::vector<int64_t> output = rng.permutation(num);
+    for (int64_t i=num; i<total; ++i) {
+        output.push_back(i);
+    }
+    return output;
+}
+
+static void
+createLUTforOneInput(const std::vector<std::vector<int64_t>>& LUT,
+                     const std::vector<int64_t>& randomVector,
+                     std::vector<std::vector<int64_t>>& LUT_input,
+                     std::vector<std::vector<int64_t>>& LUT_output,
+                     std::vector<std::vector<size_t>>& pad_slots,
+                     const int64_t l, const int64_t k)
+{
+    std::vector<int64_t> sub_input;
+    std::vector<int64_t> sub_output;
+    int64_t total = randomVector.size();
+    int64_t row_size = l;
+    int64_t index = 0;
+
+    STDSC_LOG_INFO("create new LUT. (l:%ld, k:%ld, total:%ld)",
+                   l, k, total);
+    
+    pad_slots.resize(k);
+    for (int64_t i=0; i<k; ++i) {
+        for(int64_t j=0; j<row_size; ++j) {
+            size_t s = randomVector[index];
+            int64_t temp_in = s < LUT[0].size() ? LUT[0][s] : FTS_LUT_DUMMY_INPUT;
+            sub_input.push_back(temp_in);
+            int64_t temp_out = s < LUT[1].size() ? LUT[1][s] : FTS_LUT_DUMMY_OUTPUT;
+            sub_output.push_back(temp_out);
+            if (s >= LUT[0].size()) {
+                pad_slots[i].push_back(j);
+            }
+            ++index;
+        }
+        sub_input.resize(l);
+        LUT_input.push_back(sub_input);
+        sub_input.clear();
+        sub_output.resize(l);
+        LUT_output.push_back(sub_output);
+        sub_output.clear();
+    }
+}
+
+static void
+createInputLUTforTwoInput(const std::vector<int64_t>& table_x,
+                          const std::vector<int64_t>& table_y,
+                          const std::vector<int64_t>& vi_x,
+                          const std::vector<int64_t>& vi_y,
+                          const int64_t possible_input_num_two,
+                          std::vector<std::vector<int64_t>>& permute_table_x,
+                          std::vector<std::vector<int64_t>>& permute_table_y,
+                          std::vector<std::vector<size_t>>& pad_slots_x,
+                          std::vector<std::vector<size_t>>& pad_slots_y,
+                          const int64_t l,
+                          const int64_t k)
+{
+    const int64_t nx = table_x.size();
+    const int64_t ny = table_y.size();
+
+    std::vector<int64_t> per_x, per_y;
+    for (int i=0; i<possible_input_num_two; ++i) {
+        int64_t tempx = vi_x[i];
+        int64_t tempy = vi_y[i];
+        per_x.push_back(tempx < nx ? table_x[tempx] : FTS_LUT_DUMMY_INPUT);
+        per_y.push_back(tempy < ny ? table_y[tempy] : FTS_LUT_DUMMY_INPUT);
+    }
+
+    std::vector<int64_t> sub_per_x, sub_per_y;
+    pad_slots_x.resize(k);
+    pad_slots_y.resize(k);
+    for (int i=0; i<k; ++i) {
+        for (int j=0; j<l; ++j) {
+            sub_per_x.push_back(per_x[i * l + j]);
+            sub_per_y.push_back(per_y[i * l + j]);
+            if (vi_x[i * l + j] >= nx) {
+                pad_slots_x[i].push_back(j);
+            }
+            if (vi_y[i * l + j] >= ny) {
+                pad_slots_y[i].push_back(j);
+            }
+        }
+        permute_table_x.push_back(sub_per_x);
+        sub_per_x.clear();
+        permute_table_y.push_back(sub_per_y);
+        sub_per_y.clear();
+    }
+}
+
+static void
+encodeRows(const seal::BatchEncoder& batch_encoder,
+           std::vector<std::vector<int64_t>>& rows,
+           std::vector<seal::Plaintext>& poly_rows)
+{
+    size_t slot_count = batch_encoder.slot_count();
+    poly_rows.resize(rows.size());
+
+    fts_share::TaskPool::shared().parallel_for(0, rows.size(), [&](int64_t i) {
+        rows[i].resize(slot_count);
+        batch_encoder.encode(rows[i], poly_rows[i]);
+    });
+}
+
+/**
+ * Encodes the rows which have random nonzero values on the padding slots.
+ * The rows without padding are left empty.
+ */
+static void
+encodePadRows(const seal::BatchEncoder& batch_encoder,
+              fts_share::RandomGenerator& rng,
+              const std::vector<std::vector<size_t>>& pad_slots,
+              std::vector<seal::Plaintext>& pad_rows)
+{
+    size_t slot_count = batch_encoder.slot_count();
+    pad_rows.resize(pad_slots.size());
+
+    for (size_t i=0; i<pad_slots.size(); ++i) {
+        if (pad_slots[i].empty()) {
+            continue;
+        }
+        std::vector<int64_t> values;
+        rng.fill_uniform(values, pad_slots[i].size(), 1, 5);
+        std::vector<int64_t> row(slot_count, 0);
+        for (size_t j=0; j<pad_slots[i].size(); ++j) {
+            row[pad_slots[i][j]] = values[j];
+        }
+        batch_encoder.encode(row, pad_rows[i]);
+    }
+}
+
+struct BundlePool::Impl
+{
+    using Key = std::pair<fts_share::FuncNo_t, seal::parms_id_type>;
+    
+    struct Slot
+    {
+        fts_share::FuncNo_t func_no;
+        LUTGeometry geo;
+        std::shared_ptr<seal::SEALContext> context;
+        std::shared_ptr<seal::BatchEncoder> batch_encoder;
+        std::shared_ptr<seal::Evaluator> evaluator;
+        std::deque<std::shared_ptr<const LUTBundle>> bundles;
+        uint64_t last_used;
+    };
+    
+    Impl(const std::vector<std::vector<int64_t>>& LUTin_one,
+         const std::vector<std::vector<int64_t>>& LUTin_two,
+         const size_t max_bundles,
+         const EvalMode_t eval_mode)
+        : LUTin_one_(LUTin_one),
+          LUTin_two_(LUTin_two),
+          max_bundles_(max_bundles),
+          eval_mode_(eval_mode),
+          tick_(0)
+    {
+    }
+
+    void exec(BundlePoolParam& args, std::shared_ptr<stdsc::ThreadException> te)
+    {
+        STDSC_LOG_INFO("Launched bundle pool thread. (max bundles: %lu, mode: %s)",
+                       max_bundles_, eval_mode_name(eval_mode_));
+        
+        while (!args.force_finish) {
+            std::shared_ptr<Slot> slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                slot = find_slot_to_fill();
+                if (!slot) {
+                    cond_.wait_for(lock, std::chrono::milliseconds(args.retry_interval_msec));
+                    continue;
+                }
+            }
+
+            auto bundle = build(*slot);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (slot->bundles.size() < max_bundles_) {
+                    slot->bundles.push_back(bundle);
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<const LUTBundle> pop(const fts_share::FuncNo_t func_no,
+                                         const seal::EncryptionParameters& params,
+                                         const LUTGeometry& geo)
+    {
+        std::shared_ptr<Slot> slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto key = Key(func_no, params.parms_id());
+            auto it = slots_.find(key);
+            if (it == slots_.end()) {
+                evict_slot_if_needed();
+                slot = std::make_shared<Slot>();
+                slot->func_no       = func_no;
+                slot->geo           = geo;
+                slot->context       = seal::SEALContext::Create(params);
+                slot->batch_encoder = std::make_shared<seal::BatchEncoder>(slot->context);
+                slot->evaluator     = std::make_shared<seal::Evaluator>(slot->context);
+                slots_.emplace(key, slot);
+            } else {
+                slot = it->second;
+            }
+            slot->last_used = ++tick_;
+
+            if (!slot->bundles.empty()) {
+                auto bundle = slot->bundles.front();
+                slot->bundles.pop_front();
+                cond_.notify_all();
+                STDSC_LOG_INFO("Got LUT bundle from pool. (remaining: %lu)", slot->bundles.size());
+                return bundle;
+            }
+        }
+        cond_.notify_all();
+
+        STDSC_LOG_INFO("LUT bundle pool is empty. Make a bundle on the spot.");
+        return build(*slot);
+    }
+
+    std::shared_ptr<Slot> find_slot_to_fill() const
+    {
+        std::shared_ptr<Slot> slot;
+        for (const auto& pair : slots_) {
+            const auto& s = pair.second;
+            if (s->bundles.size() < max_bundles_ &&
+                (!slot || s->bundles.size() < slot->bundles.size())) {
+                slot = s;
+            }
+        }
+        return slot;
+    }
+
+    void evict_slot_if_needed()
+    {
+        while (slots_.size() >= BUNDLEPOOL_MAX_PARAMS) {
+            auto oldest = slots_.begin();
+            for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+                if (it->second->last_used < oldest->second->last_used) {
+                    oldest = it;
+                }
+            }
+            slots_.erase(oldest);
+        }
+    }
+
+    std::shared_ptr<const LUTBundle> build(const Slot& slot) const
+    {
+        auto bundle = std::make_shared<LUTBundle>();
+        const auto& geo = slot.geo;
+        const auto stream_base = fts_share::RandomGenerator::new_stream_base();
+        
+        if (slot.func_no == fts_share::kFuncTwo) {
+            const auto& table_x = LUTin_two_[0];
+            const auto& table_y = LUTin_two_[1];
+            fts_share::RandomGenerator rng_x(stream_base), rng_y(stream_base + 1);
+            bundle->perms_.push_back(get_randomvector(rng_x, table_x.size(), geo.possible_input_num));
+            bundle->perms_.push_back(get_randomvector(rng_y, table_y.size(), geo.possible_input_num));
+
+            std::vector<std::vector<int64_t>> permute_table_x, permute_table_y;
+            bundle->pad_slots_.resize(2);
+            createInputLUTforTwoInput(table_x, table_y,
+                                      bundle->perms_[0], bundle->perms_[1],
+                                      geo.possible_input_num,
+                                      permute_table_x, permute_table_y,
+                                      bundle->pad_slots_[0], bundle->pad_slots_[1],
+                                      geo.l, geo.k);
+
+            bundle->input_rows_.resize(2);
+            encodeRows(*slot.batch_encoder, permute_table_x, bundle->input_rows_[0]);
+            encodeRows(*slot.batch_encoder, permute_table_y, bundle->input_rows_[1]);
+
+            fts_share::RandomGenerator rng_pad(stream_base + 2);
+            bundle->pad_rows_.resize(2);
+            encodePadRows(*slot.batch_encoder, rng_pad, bundle->pad_slots_[0], bundle->pad_rows_[0]);
+            encodePadRows(*slot.batch_encoder, rng_pad, bundle->pad_slots_[1], bundle->pad_rows_[1]);
+        } else {
+            fts_share::RandomGenerator rng(stream_base);
+            bundle->perms_.push_back(rng.permutation(geo.possible_input_num));
+
+            std::vector<std::vector<int64_t>> LUT_input, LUT_output;
+            bundle->pad_slots_.resize(1);
+            createLUTforOneInput(LUTin_one_, bundle->perms_[0],
+                                 LUT_input, LUT_output, bundle->pad_slots_[0],
+                                 geo.l * geo.rows, geo.k);
+
+            bundle->input_rows_.resize(1);
+            encodeRows(*slot.batch_encoder, LUT_input, bundle->input_rows_[0]);
+            encodeRows(*slot.batch_encoder, LUT_output, bundle->output_rows_);
+
+            fts_share::RandomGenerator rng_pad(stream_base + 1);
+            bundle->pad_rows_.resize(1);
+            encodePadRows(*slot.batch_encoder, rng_pad, bundle->pad_slots_[0], bundle->pad_rows_[0]);
+
+            if (eval_mode_ == kEvalModeNTT) {
+                const auto parms_id = slot.context->first_parms_id();
+                fts_share::TaskPool::shared().parallel_for(0, bundle->output_rows_.size(), [&](int64_t i) {
+                    slot.evaluator->transform_to_ntt_inplace(bundle->output_rows_[i], parms_id);
+                });
+            }
+        }
+        
+        return bundle;
+    }
+
+    const std::vector<std::vector<int64_t>>& LUTin_one_;
+    const std::vector<std::vector<int64_t>>& LUTin_two_;
+    const size_t max_bundles_;
+    const EvalMode_t eval_mode_;
+    uint64_t tick_;
+    std::map<Key, std::shared_ptr<Slot>> slots_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    BundlePoolParam param_;
+    std::shared_ptr<stdsc::ThreadException> te_;
+};
+
+BundlePool::BundlePool(const std::vector<std::vector<int64_t>>& LUTin_one,
+                       const std::vector<std::vector<int64_t>>& LUTin_two,
+                       const size_t max_bundles,
+                       const EvalMode_t eval_mode)
+    : pimpl_(new Impl(LUTin_one, LUTin_two, max_bundles, eval_mode))
+{}
+
+void BundlePool::start()
+{
+    pimpl_->param_.force_finish = false;
+    super::start(pimpl_->param_, pimpl_->te_);
+}
+
+void BundlePool::stop()
+{
+    STDSC_LOG_INFO("Stop bundle pool thread.");
+    pimpl_->param_.force_finish = true;
+    pimpl_->cond_.notify_all();
+}
+
+std::shared_ptr<const LUTBundle>
+BundlePool::pop(const fts_share::FuncNo_t func_no,
+                const seal::EncryptionParameters& params,
+                const LUTGeometry& geo)
+{
+    return pimpl_->pop(func_no, params, geo);
+}
+
+void BundlePool::exec(BundlePoolParam& args, std::shared_ptr<stdsc::ThreadException> te) const
+{
+    pimpl_->exec(args, te);
+}
+
+} /* namespace fts_cs */
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_BUNDLEPOOL_HPP
+#define FTS_CS_BUNDLEPOOL_HPP
+
+#include <memory>
+#include <vector>
+#include <stdsc/stdsc_thread.hpp>
+#include <fts_share/fts_funcno.hpp>
+#include <fts_cs/fts_cs_evalmode.hpp>
+#include <seal/seal.h>
+
+namespace fts_cs
+{
+
+class BundlePoolParam;
+struct LUTGeometry;
+
+/**
+ * @brief This class is used to hold the permuted and encoded LUT for a query.
+ *
+ * For one input, perms_[0] is the permutation, input_rows_[0] are the encoded
+ * input rows and output_rows_ are the encoded output rows.
+ * For two input, perms_[0] and perms_[1] are the permutations of x and y and
+ * input_rows_[0] and input_rows_[1] are the encoded input rows of x and y.
+ * The output rows are in NTT form if the pool runs in kEvalModeNTT.
+ * The output rows of two input are too large to keep in the pool,
+ * so they are made in the online phase from the permutations.
+ *
+ * pad_slots_[i][r] are the padding slots of input_rows_[i][r], and
+ * pad_rows_[i][r] has nonzero values on them (empty if no padding).
+ * computationA clears the masks of the padding slots and adds pad_rows_,
+ * so that a padding slot never matches any query.
+ */
+struct LUTBundle
+{
+    std::vector<std::vector<int64_t>> perms_;
+    std::vector<std::vector<seal::Plaintext>> input_rows_;
+    std::vector<seal::Plaintext> output_rows_;
+    std::vector<std::vector<std::vector<size_t>>> pad_slots_;
+    std::vector<std::vector<seal::Plaintext>> pad_rows_;
+};
+
+/**
+ * @brief Provides the pool of LUT bundles prepared in background.
+ *        The pool holds bundles for each pair of function and encryption
+ *        parameters which have been requested by queries.
+ */
+class BundlePool : public stdsc::Thread<BundlePoolParam>
+{
+    using super = Thread<BundlePoolParam>;
+public:
+    /**
+     * Constructor
+     * @param[in] LUTin_one   input LUT for one input
+     * @param[in] LUTin_two   input LUT for two input
+     * @param[in] max_bundles max number of bundles to hold for each parameters
+     * @param[in] eval_mode   evaluation mode
+     */
+    BundlePool(const std::vector<std::vector<int64_t>>& LUTin_one,
+               const std::vector<std::vector<int64_t>>& LUTin_two,
+               const size_t max_bundles,
+               const EvalMode_t eval_mode = kEvalModeNTT);
+    virtual ~BundlePool(void) = default;
+
+    /**
+     * Start thread
+     */
+    void start();
+
+    /**
+     * Stop thread
+     */
+    void stop();
+
+    /**
+     * Get bundle. The bundle is made on the spot if the pool is empty.
+     * @param[in] func_no function number
+     * @param[in] params  encryption parameters
+     * @param[in] geo     geometry of LUT
+     * @return bundle
+     */
+    std::shared_ptr<const LUTBundle> pop(const fts_share::FuncNo_t func_no,
+                                         const seal::EncryptionParameters& params,
+                                         const LUTGeometry& geo);
+
+private:
+    virtual void exec(BundlePoolParam& args,
+                      std::shared_ptr<stdsc::ThreadException> te) const override;
+
+    struct Impl;
+    std::shared_ptr<Impl> pimpl_;
+};
+
+/**
+ * @brief This class is used to hold the parameters for BundlePool.
+ */
+struct BundlePoolParam
+{
+    uint32_t retry_interval_msec = DefaultRetryIntervalMsec;
+    bool force_finish = false;
+
+    static constexpr uint32_t DefaultRetryIntervalMsec = 100;
+};
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_BUNDLEPOOL_HPP */
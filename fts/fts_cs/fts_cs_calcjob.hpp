@@ -0,0 +1,101 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_CALCJOB_HPP
+#define FTS_CS_CALCJOB_HPP
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <fts_cs/fts_cs_query.hpp>
+#include <fts_cs/fts_cs_scheduler.hpp>
+#include <fts_cs/fts_cs_lutgeometry.hpp>
+#include <fts_cs/fts_cs_calcstage.hpp>
+#include <seal/seal.h>
+
+namespace fts_cs
+{
+
+struct KeyContext;
+struct LUTBundle;
+
+/**
+ * @brief This class is used to hold the state of a query passed between stages.
+ */
+struct CalcJob
+{
+    int32_t query_id_;
+    Query query_;
+    SchedEntry sched_;                           // scheduling attributes
+    std::shared_ptr<const KeyContext> kctx_;
+    LUTGeometry geo_;
+    std::shared_ptr<const LUTBundle> bundle_;
+    std::vector<seal::Ciphertext> midresults_x_; // intermediate results (x)
+    std::vector<seal::Ciphertext> midresults_y_; // intermediate results (y), two input only
+    std::vector<seal::Ciphertext> PIRqueries_;   // one input: [0] query, [1] index
+                                                 // two input: [0] query0, [1] query1, [2] query2
+    seal::Ciphertext result_;                    // computationB result
+
+    /**
+     * Check if query is cancelled
+     * @return true if cancelled
+     */
+    bool is_cancelled(void) const
+    {
+        return query_.cancelled_ && query_.cancelled_->load();
+    }
+
+    /**
+     * Check if deadline of query has passed
+     * @return true if expired
+     */
+    bool is_expired(void) const
+    {
+        return sched_.has_deadline && SchedEntry::Clock::now() > sched_.deadline;
+    }
+
+    /**
+     * Check if the rest of computation is to be dropped
+     * @return true if cancelled or expired
+     */
+    bool is_aborted(void) const
+    {
+        return is_cancelled() || is_expired();
+    }
+};
+
+/**
+ * @brief This class is used to hold the queue of jobs waiting for a stage.
+ */
+struct CalcJobQueue : public ScheduledQueue<std::shared_ptr<CalcJob>>
+{
+    using super = ScheduledQueue<std::shared_ptr<CalcJob>>;
+
+    CalcJobQueue() = default;
+    virtual ~CalcJobQueue() = default;
+};
+
+/**
+ * @brief Input queues of each stage. The key fetch stage reads QueryQueue,
+ *        so the queue of kCalcStageKeyFetch is not used.
+ */
+using CalcJobQueues = std::array<CalcJobQueue, kNumOfCalcStages>;
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_CALCJOB_HPP */
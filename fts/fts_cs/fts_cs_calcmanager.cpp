@@ -16,6 +16,9 @@
  */
 
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
 #include <unistd.h>
 #include <fstream>
 #include <stdsc/stdsc_log.hpp>
@@ -24,8 +27,16 @@
 #include <fts_share/fts_define.hpp>
 #include <fts_cs/fts_cs_query.hpp>
 #include <fts_cs/fts_cs_result.hpp>
+#include <fts_cs/fts_cs_result_reaper.hpp>
+#include <fts_cs/fts_cs_admission.hpp>
+#include <fts_cs/fts_cs_lutgeometry.hpp>
 #include <fts_cs/fts_cs_lut.hpp>
+#include <fts_cs/fts_cs_keycache.hpp>
+#include <fts_cs/fts_cs_dec_client_pool.hpp>
+#include <fts_cs/fts_cs_bundlepool.hpp>
+#include <fts_cs/fts_cs_calcjob.hpp>
 #include <fts_cs/fts_cs_calcthread.hpp>
+#include <fts_cs/fts_cs_metrics.hpp>
 #include <fts_cs/fts_cs_calcmanager.hpp>
 
 
@@ -37,11 +48,35 @@ namespace fts_cs
         Impl(const std::string& LUT_dir,
              const uint32_t max_concurrent_queries,
              const uint32_t max_results,
-             const uint32_t result_lifetime_sec)
+             const uint32_t result_lifetime_sec,
+             const size_t max_cached_keys,
+             const size_t max_cached_key_bytes,
+             const size_t max_bundles,
+             const EvalMode_t eval_mode,
+             const size_t max_query_bytes,
+             const int64_t packed_rows,
+             const SchedPolicy_t sched_policy,
+             const size_t max_result_bytes,
+             const size_t max_inflight_bytes,
+             const double max_inflight_cost)
             : max_concurrent_queries_(max_concurrent_queries),
               max_results_(max_results),
-              result_lifetime_sec_(result_lifetime_sec)
+              result_lifetime_sec_(result_lifetime_sec),
+              max_result_bytes_(max_result_bytes),
+              max_cached_keys_(max_cached_keys),
+              max_cached_key_bytes_(max_cached_key_bytes),
+              max_bundles_(max_bundles),
+              eval_mode_(eval_mode),
+              max_query_bytes_(max_query_bytes),
+              packed_rows_(packed_rows),
+              qque_(sched_policy),
+              admission_(max_inflight_bytes, max_inflight_cost)
         {
+            for (auto& que : jque_) {
+                que.set_policy(sched_policy);
+            }
+            STDSC_LOG_INFO("Scheduling policy of queries: %s", sched_policy_name(sched_policy));
+
             LUTLFunc LUTlfunc;
             LUTQFunc LUTqfunc;
             auto files = fts_share::utility::get_filelist(LUT_dir, FTS_LUTFILE_EXT);
@@ -49,11 +84,10 @@ namespace fts_cs
                 auto func = fts_cs_lut_get_funcnumber(f);
                 if (func == kLUTFuncLinear) {
                     LUTlfunc.load_from_file(f);
-                    convertLUT_to_vecfmt_one(LUTlfunc, LUTin_one_, possible_input_num_one_);
+                    convertLUT_to_vecfmt_one(LUTlfunc, LUTin_one_);
                 } else if (func == kLUTFuncQuadratic) {
                     LUTqfunc.load_from_file(f);
-                    convertLUT_to_vecfmt_two(LUTqfunc, LUTin_two_, LUTout_two_,
-                                             possible_input_num_two_, possible_combination_num_two_);
+                    convertLUT_to_vecfmt_two(LUTqfunc, LUTin_two_, LUTout_two_);
                 } else {
                     STDSC_THROW_FILE("The LUT file has an invalid format.");
                 }
@@ -61,8 +95,7 @@ namespace fts_cs
         }
 
         void convertLUT_to_vecfmt_one(LUTLFunc& lut,
-                                      std::vector<std::vector<int64_t>>& lutvec_io,
-                                      int64_t& possible_input_num) const
+                                      std::vector<std::vector<int64_t>>& lutvec_io) const
         {
             lutvec_io.clear();
             lutvec_io.resize(2); // [0]: input cols (x), [1]: output cols (y)
@@ -72,16 +105,16 @@ namespace fts_cs
                 lutvec_io[0].push_back(stol(key));
                 lutvec_io[1].push_back(val);
             }
-            lutvec_io[0].resize(FTS_LUT_POSSIBLE_INPUT_NUM_ONE, 100);
-            lutvec_io[1].resize(FTS_LUT_POSSIBLE_INPUT_NUM_ONE, 100);            
-            possible_input_num = FTS_LUT_POSSIBLE_INPUT_NUM_ONE;
+
+            // The table is kept unpadded. CalcThread pads it to the next
+            // row boundary of the plaintext matrix for each query.
+            STDSC_THROW_INVPARAM_IF_CHECK(lutvec_io[0].size() <= FTS_LUT_POSSIBLE_INPUT_NUM_ONE,
+                                          "size of LUT of one input size too large");
         }
 
         void convertLUT_to_vecfmt_two(LUTQFunc& lut,
                                       std::vector<std::vector<int64_t>>& lutvec_i,
-                                      std::vector<int64_t>& lutvec_o,
-                                      int64_t& possible_input_num,
-                                      int64_t& possible_combination_num) const
+                                      std::vector<int64_t>& lutvec_o) const
         {
             lutvec_i.clear();
             lutvec_o.clear();
@@ -103,74 +136,181 @@ namespace fts_cs
             STDSC_THROW_INVPARAM_IF_CHECK(x0sz < FTS_LUT_POSSIBLE_INPUT_NUM_TWO, "size of x0 in LUT of two input size too large");
             STDSC_THROW_INVPARAM_IF_CHECK(x1sz < FTS_LUT_POSSIBLE_INPUT_NUM_TWO, "size of x1 in LUT of two input size too large");
 
-            lutvec_i[0].resize(FTS_LUT_POSSIBLE_INPUT_NUM_TWO, 100);
-            lutvec_i[1].resize(FTS_LUT_POSSIBLE_INPUT_NUM_TWO, 100);
-
-            for (size_t i=0; i<lutvec_i[0].size(); ++i) {
+            // The output table is stored as x0sz * x1sz matrix (row-major).
+            // CalcThread pads it to the row size of the plaintext matrix for each query.
+            lutvec_o.reserve(x0sz * x1sz);
+            for (size_t i=0; i<x0sz; ++i) {
                 
                 const auto& x0 = lutvec_i[0][i];
-                for (size_t j=0; j<lutvec_i[1].size(); ++j) {
+                for (size_t j=0; j<x1sz; ++j) {
                     
-                    int64_t val = 1000;
-                    if (i < x0sz && j < x1sz) {
-                        try {
-                            const auto& x1 = lutvec_i[1][j];
-                            val = lut.get(x0, x1);
-                        }catch (stdsc::InvParamException& ex) {
-                            // nothing to do
-                        }
+                    int64_t val = FTS_LUT_DUMMY_OUTPUT;
+                    try {
+                        const auto& x1 = lutvec_i[1][j];
+                        val = lut.get(x0, x1);
+                    }catch (stdsc::InvParamException& ex) {
+                        // nothing to do
                     }
                     
                     lutvec_o.push_back(val);
                 }
             }
-            
-            possible_input_num = FTS_LUT_POSSIBLE_INPUT_NUM_TWO;
-            possible_combination_num = possible_input_num * possible_input_num;
+        }
+
+        /**
+         * Estimate work of query relative to others. The work of both
+         * computations is proportional to the num of table entries,
+         * and two input LUT computes two intermediate results.
+         */
+        double estimate_cost(const fts_share::FuncNo_t func_no) const
+        {
+            if (func_no == fts_share::kFuncTwo) {
+                return LUTin_two_.empty()
+                    ? 1.0 : 2.0 * LUTin_two_[0].size() * LUTin_two_[1].size();
+            }
+            return LUTin_one_.empty()
+                ? 1.0 : static_cast<double>(LUTin_one_[0].size());
+        }
+
+        /**
+         * Estimate memory of query. Intermediate results are kept for
+         * each row of input tables, and computationB of two input
+         * is done in chunks within max_query_bytes.
+         */
+        size_t estimate_bytes(const Query& query) const
+        {
+            if (query.ctxts_.empty()) {
+                return 0;
+            }
+            const size_t ctxt_bytes = query.ctxts_[0].uint64_count() * sizeof(uint64_t);
+            const int64_t row_size = query.ctxts_[0].poly_modulus_degree() / 2;
+            size_t num_ctxts = query.ctxts_.size();
+            size_t chunk_bytes = 0;
+            if (row_size > 0) {
+                if (query.func_no_ == fts_share::kFuncTwo && !LUTin_two_.empty()) {
+                    auto geo = calcLUTGeometryForTwoInput(LUTin_two_[0].size(), LUTin_two_[1].size(), row_size);
+                    num_ctxts += 2 * geo.k;
+                    chunk_bytes = std::min(max_query_bytes_, geo.ks * ctxt_bytes);
+                } else if (query.func_no_ != fts_share::kFuncTwo && !LUTin_one_.empty()) {
+                    auto geo = calcLUTGeometryForOneInput(LUTin_one_[0].size(), row_size, packed_rows_);
+                    num_ctxts += geo.k + 2;
+                }
+            }
+            return num_ctxts * ctxt_bytes + chunk_bytes;
         }
 
         const uint32_t max_concurrent_queries_;
         const uint32_t max_results_;
         const uint32_t result_lifetime_sec_;
+        const size_t max_result_bytes_;
+        const size_t max_cached_keys_;
+        const size_t max_cached_key_bytes_;
+        const size_t max_bundles_;
+        const EvalMode_t eval_mode_;
+        const size_t max_query_bytes_;
+        const int64_t packed_rows_;
         QueryQueue qque_;
+        AdmissionControl admission_;
+        CalcJobQueues jque_;
         ResultQueue rque_;
+        CalcMetrics metrics_;
+        // Check if query is still computed. The result is pushed before
+        // the flag expires, so the result queue must be looked up after
+        // this returns false.
+        bool is_computing(const int32_t query_id)
+        {
+            std::lock_guard<std::mutex> lock(cancel_mtx_);
+            auto it = cancel_flags_.find(query_id);
+            return it != cancel_flags_.end() && !it->second.expired();
+        }
+
+        std::mutex cancel_mtx_;
+        // The flags expire when the computation of query ends.
+        std::unordered_map<int32_t, std::weak_ptr<std::atomic<bool>>> cancel_flags_;
         std::vector<std::vector<int64_t>> LUTin_one_;
         std::vector<std::vector<int64_t>> LUTin_two_;
         std::vector<int64_t> LUTout_two_;
-        int64_t possible_input_num_one_;
-        int64_t possible_input_num_two_;
-        int64_t possible_combination_num_two_;
+        std::shared_ptr<DecClientPool> dec_pool_;
+        std::shared_ptr<KeyCache> key_cache_;
+        std::shared_ptr<BundlePool> bundle_pool_;
+        std::shared_ptr<ResultReaper> result_reaper_;
         std::vector<std::shared_ptr<CalcThread>> threads_;
     };
 
     CalcManager::CalcManager(const std::string& LUT_dir,
                              const uint32_t max_concurrent_queries,
                              const uint32_t max_results,
-                             const uint32_t result_lifetime_sec)
+                             const uint32_t result_lifetime_sec,
+                             const size_t max_cached_keys,
+                             const size_t max_cached_key_bytes,
+                             const size_t max_bundles,
+                             const EvalMode_t eval_mode,
+                             const size_t max_query_bytes,
+                             const int64_t packed_rows,
+                             const SchedPolicy_t sched_policy,
+                             const size_t max_result_bytes,
+                             const size_t max_inflight_bytes,
+                             const double max_inflight_cost)
         :pimpl_(new Impl(LUT_dir,
                          max_concurrent_queries,
                          max_results,
-                         result_lifetime_sec))
+                         result_lifetime_sec,
+                         max_cached_keys,
+                         max_cached_key_bytes,
+                         max_bundles,
+                         eval_mode,
+                         max_query_bytes,
+                         packed_rows,
+                         sched_policy,
+                         max_result_bytes,
+                         max_inflight_bytes,
+                         max_inflight_cost))
     {}
 
-    void CalcManager::start_threads(const uint32_t thread_num,
+    void CalcManager::start_threads(const CalcStageThreads& stage_threads,
                                     const std::string& dec_host,
                                     const std::string& dec_port)
     {
-        STDSC_LOG_INFO("Start calculation threads. (n:%d)", thread_num);
+        STDSC_LOG_INFO("Start calculation threads. (key fetch:%u, computationA:%u, decryptor exchange:%u, computationB:%u)",
+                       stage_threads.key_fetch, stage_threads.compute_a,
+                       stage_threads.dec_exchange, stage_threads.compute_b);
         pimpl_->threads_.clear();
-        for (size_t i=0; i<thread_num; ++i) {
-            pimpl_->threads_.emplace_back(
-                std::make_shared<CalcThread>(pimpl_->qque_,
-                                             pimpl_->rque_,
-                                             pimpl_->LUTin_one_,
-                                             pimpl_->LUTin_two_,
-                                             pimpl_->LUTout_two_,
-                                             pimpl_->possible_input_num_one_,
-                                             pimpl_->possible_input_num_two_,
-                                             pimpl_->possible_combination_num_two_,
-                                             dec_host,
-                                             dec_port));
+        // Each thread of key fetch and decryptor exchange stages uses
+        // at most one connection at a time.
+        const size_t max_dec_clients = std::max<size_t>(1, stage_threads.key_fetch + stage_threads.dec_exchange);
+        pimpl_->dec_pool_ = std::make_shared<DecClientPool>(dec_host, dec_port, max_dec_clients);
+        pimpl_->key_cache_ = std::make_shared<KeyCache>(*pimpl_->dec_pool_,
+                                                        pimpl_->max_cached_keys_,
+                                                        pimpl_->max_cached_key_bytes_);
+        pimpl_->bundle_pool_ = std::make_shared<BundlePool>(pimpl_->LUTin_one_,
+                                                            pimpl_->LUTin_two_,
+                                                            pimpl_->max_bundles_,
+                                                            pimpl_->eval_mode_);
+        pimpl_->bundle_pool_->start();
+        pimpl_->result_reaper_ = std::make_shared<ResultReaper>(pimpl_->rque_,
+                                                                pimpl_->metrics_,
+                                                                pimpl_->result_lifetime_sec_,
+                                                                pimpl_->max_result_bytes_);
+        pimpl_->result_reaper_->start();
+        for (int32_t s=0; s<kNumOfCalcStages; ++s) {
+            const auto stage = static_cast<CalcStage_t>(s);
+            for (size_t i=0; i<stage_threads.get(stage); ++i) {
+                pimpl_->threads_.emplace_back(
+                    std::make_shared<CalcThread>(stage,
+                                                 pimpl_->qque_,
+                                                 pimpl_->jque_,
+                                                 pimpl_->rque_,
+                                                 *pimpl_->key_cache_,
+                                                 *pimpl_->bundle_pool_,
+                                                 pimpl_->LUTin_one_,
+                                                 pimpl_->LUTin_two_,
+                                                 pimpl_->LUTout_two_,
+                                                 *pimpl_->dec_pool_,
+                                                 pimpl_->metrics_,
+                                                 pimpl_->eval_mode_,
+                                                 pimpl_->max_query_bytes_,
+                                                 pimpl_->packed_rows_));
+            }
         }
 
         for (const auto& thread : pimpl_->threads_) {
@@ -181,50 +321,139 @@ namespace fts_cs
     void CalcManager::stop_threads()
     {
         STDSC_LOG_INFO("Stop calculation threads.");
+        if (pimpl_->bundle_pool_) {
+            pimpl_->bundle_pool_->stop();
+        }
+        if (pimpl_->result_reaper_) {
+            pimpl_->result_reaper_->stop();
+        }
+        if (pimpl_->dec_pool_) {
+            pimpl_->dec_pool_->close();
+        }
     }
     
-    int32_t CalcManager::push_query(const Query& query)
+    int32_t CalcManager::push_query(Query& query, uint32_t& retry_after_msec)
     {
         STDSC_LOG_INFO("Set queries.");
         int32_t query_id = -1;
+        retry_after_msec = 0;
+        
+        // Queries waiting in any stage are counted as concurrent queries.
+        size_t num_queries = pimpl_->qque_.size();
+        for (const auto& que : pimpl_->jque_) {
+            num_queries += que.size();
+        }
         
-        if (pimpl_->qque_.size() < pimpl_->max_concurrent_queries_ &&
-            pimpl_->rque_.size() < pimpl_->max_results_) {
-            try {
-                query_id = pimpl_->qque_.push(query);
-            } catch (stdsc::AbstractException& ex) {
-                STDSC_LOG_WARN(ex.what());
+        const double cost = pimpl_->estimate_cost(query.func_no_);
+        if (num_queries >= pimpl_->max_concurrent_queries_ ||
+            pimpl_->rque_.size() >= pimpl_->max_results_) {
+            retry_after_msec = pimpl_->admission_.retry_after_msec();
+            STDSC_LOG_INFO("Rejected query because queues are full. (retry after: %u msec)",
+                           retry_after_msec);
+        } else {
+            query.admission_ = pimpl_->admission_.admit(pimpl_->estimate_bytes(query),
+                                                        cost, retry_after_msec);
+        }
+        if (!query.admission_) {
+            ++pimpl_->metrics_.rejected_queries;
+            return query_id;
+        }
+
+        try {
+            std::lock_guard<std::mutex> lock(pimpl_->cancel_mtx_);
+            query_id = pimpl_->qque_.push(query, cost);
+            pimpl_->cancel_flags_[query_id] = query.cancelled_;
+            if (pimpl_->cancel_flags_.size() > 2 * pimpl_->max_concurrent_queries_) {
+                for (auto it = pimpl_->cancel_flags_.begin(); it != pimpl_->cancel_flags_.end(); ) {
+                    it = it->second.expired() ? pimpl_->cancel_flags_.erase(it) : std::next(it);
+                }
             }
+        } catch (stdsc::AbstractException& ex) {
+            STDSC_LOG_WARN(ex.what());
+            query.admission_.reset();
         }
             
         return query_id;
     }
 
-    void CalcManager::pop_result(const int32_t query_id, Result& result,
+    bool CalcManager::cancel_query(const int32_t query_id)
+    {
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(pimpl_->cancel_mtx_);
+            auto it = pimpl_->cancel_flags_.find(query_id);
+            if (it != pimpl_->cancel_flags_.end()) {
+                auto flag = it->second.lock();
+                pimpl_->cancel_flags_.erase(it);
+                if (flag) {
+                    // CalcThread drops the query at the next row or stage.
+                    flag->store(true);
+                    STDSC_LOG_INFO("Cancelled query #%d.", query_id);
+                    found = true;
+                }
+            }
+        }
+
+        // The result may have been produced before the flag is set.
+        // A result pushed after this is deleted by CalcThread, which checks
+        // the flag again after the push.
+        Result result;
+        if (pimpl_->rque_.pop(query_id, result)) {
+            ++pimpl_->metrics_.cancelled_queries;
+            STDSC_LOG_INFO("Deleted the results of query #%d by cancel request.", query_id);
+            found = true;
+        }
+        return found;
+    }
+
+    const CalcMetrics& CalcManager::metrics() const
+    {
+        return pimpl_->metrics_;
+    }
+
+    bool CalcManager::pop_result(const int32_t query_id, Result& result,
                                  const uint32_t retry_interval_msec) const
     {
         STDSC_LOG_INFO("Getting results of query. (retry_interval_msec: %u ms)", retry_interval_msec);
-        while (!pimpl_->rque_.pop(query_id, result)) {
-            usleep(retry_interval_msec * 1000);
+        // The result is handed over as soon as it is pushed.
+        while (!pimpl_->rque_.wait_pop(query_id, result, retry_interval_msec)) {
+            if (!pimpl_->is_computing(query_id)) {
+                return pimpl_->rque_.pop(query_id, result);
+            }
+            STDSC_LOG_TRACE("Waiting results of query #%d.", query_id);
+        }
+        return true;
+    }
+
+    fts_share::CsCalcResult_t
+    CalcManager::poll_result(const int32_t query_id, Result& result,
+                             const uint32_t timeout_msec) const
+    {
+        auto status_of = [&result]() {
+            return result.status_ ? fts_share::kCsCalcResultSuccess
+                                  : fts_share::kCsCalcResultFailed;
+        };
+
+        if (pimpl_->rque_.pop(query_id, result)) {
+            return status_of();
+        }
+        if (!pimpl_->is_computing(query_id)) {
+            return pimpl_->rque_.pop(query_id, result) ? status_of()
+                                                       : fts_share::kCsCalcResultNotFound;
+        }
+        if (timeout_msec > 0 && pimpl_->rque_.wait_pop(query_id, result, timeout_msec)) {
+            return status_of();
         }
+        return fts_share::kCsCalcResultPending;
     }
 
     void CalcManager::cleanup_results()
     {
-        if (pimpl_->rque_.size() >= pimpl_->max_results_) {
-            std::vector<int32_t> query_ids;
-            for (const auto& pair : pimpl_->rque_) {
-                const auto& query_id = pair.first;
-                const auto& result   = pair.second;
-                if (result.elapsed_time() >= pimpl_->result_lifetime_sec_) {
-                    STDSC_LOG_INFO("Deleted the results of query%d because it has expired.", query_id);
-                    query_ids.push_back(query_id);
-                }
-            }
-            Result tmp;
-            for (const auto& id : query_ids) {
-                pimpl_->rque_.pop(id, tmp);
-            }
+        if (pimpl_->result_reaper_) {
+            pimpl_->result_reaper_->reap();
+        } else {
+            ResultReaper(pimpl_->rque_, pimpl_->metrics_,
+                         pimpl_->result_lifetime_sec_, pimpl_->max_result_bytes_).reap();
         }
     }
 
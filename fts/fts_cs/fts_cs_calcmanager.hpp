@@ -21,12 +21,18 @@
 #include <memory>
 #include <cstdbool>
 #include <string>
+#include <fts_share/fts_define.hpp>
+#include <fts_share/fts_cs2userparam.hpp>
+#include <fts_cs/fts_cs_evalmode.hpp>
+#include <fts_cs/fts_cs_calcstage.hpp>
+#include <fts_cs/fts_cs_scheduler.hpp>
 
 namespace fts_cs
 {
 
 class Query;
 class Result;
+struct CalcMetrics;
 
 class CalcManager
 {
@@ -37,20 +43,40 @@ public:
      * @param[in] max_concurrent_queries max number of concurrent queries
      * @param[in] max_results max        result number to hold
      * @param[in] result_lifetime_sec    lifetime to hold (sec)
+     * @param[in] max_cached_keys        max number of keys to cache
+     * @param[in] max_cached_key_bytes   max total size of keys to cache (bytes)
+     * @param[in] max_bundles            max number of LUT bundles to prepare in background
+     * @param[in] eval_mode              evaluation mode of computationB
+     * @param[in] max_query_bytes        memory budget of computationB per query (bytes)
+     * @param[in] packed_rows            num of batching rows packed per ciphertext for one input (1 or 2)
+     * @param[in] sched_policy           scheduling policy of queries
+     * @param[in] max_result_bytes       max total size of results to hold (bytes)
+     * @param[in] max_inflight_bytes     max estimated memory of queries in flight (bytes)
+     * @param[in] max_inflight_cost      max estimated work of queries in flight
      */
     CalcManager(const std::string& LUT_dir,
                 const uint32_t max_concurrent_queries,
                 const uint32_t max_results,
-                const uint32_t result_lifetime_sec);
+                const uint32_t result_lifetime_sec,
+                const size_t max_cached_keys = FTS_DEFAULT_MAX_CACHED_KEYS,
+                const size_t max_cached_key_bytes = FTS_DEFAULT_MAX_CACHED_KEY_BYTES,
+                const size_t max_bundles = FTS_DEFAULT_MAX_LUT_BUNDLES,
+                const EvalMode_t eval_mode = kEvalModeNTT,
+                const size_t max_query_bytes = FTS_DEFAULT_MAX_QUERY_BYTES,
+                const int64_t packed_rows = FTS_DEFAULT_PACKED_ROWS,
+                const SchedPolicy_t sched_policy = kSchedPolicyFair,
+                const size_t max_result_bytes = FTS_DEFAULT_MAX_RESULT_BYTES,
+                const size_t max_inflight_bytes = FTS_DEFAULT_MAX_INFLIGHT_BYTES,
+                const double max_inflight_cost = FTS_DEFAULT_MAX_INFLIGHT_COST);
     virtual ~CalcManager() = default;
 
     /**
-     * Start calculation threads
-     * @param[in] thread_num number of threads
+     * Start calculation threads of each stage
+     * @param[in] stage_threads number of threads of each stage
      * @param[in] dec_host hostname of decryptor
      * @param[in] dec_port port number of decryptor
      */
-    void start_threads(const uint32_t thread_num,
+    void start_threads(const CalcStageThreads& stage_threads,
                        const std::string& dec_host,
                        const std::string& dec_port);
 
@@ -60,23 +86,54 @@ public:
     void stop_threads();
 
     /**
-     * Set queries
-     * @param[in] query query
-     * @return query ID
+     * Set queries. The query is rejected if the queues are full or
+     * the estimated memory or work of queries in flight exceed the limits.
+     * @param[in,out] query query, which holds the reservation while in flight
+     * @param[out] retry_after_msec time to retry after if rejected by overload (msec, 0: not rejected)
+     * @return query ID (-1: rejected or failed)
      */
-    int32_t push_query(const Query& query);
+    int32_t push_query(Query& query, uint32_t& retry_after_msec);
 
     /**
-     * Get results of query
+     * Get results of query. Blocks until the result is produced.
      * @paran[in] query_id query ID
      * @param[out] result result
-     * @param[in] retry_interval_usec retry interval (usec)
+     * @param[in] retry_interval_msec timeout of each wait (msec)
+     * @return false if query is not found, i.e. the query is unknown,
+     *         cancelled or its result has been deleted
      */
-    void pop_result(const int32_t query_id, Result& result,
+    bool pop_result(const int32_t query_id, Result& result,
                     const uint32_t retry_interval_msec=100) const;
 
     /**
-     * Delete results if number of results grater than max number and expired lifetime
+     * Get results of query if produced within timeout.
+     * @paran[in] query_id query ID
+     * @param[out] result result
+     * @param[in] timeout_msec timeout (msec, 0: returns immediately)
+     * @return kCsCalcResultSuccess or kCsCalcResultFailed if result is got,
+     *         kCsCalcResultPending if query is still computed,
+     *         kCsCalcResultNotFound if query is not found
+     */
+    fts_share::CsCalcResult_t poll_result(const int32_t query_id, Result& result,
+                                          const uint32_t timeout_msec) const;
+
+    /**
+     * Cancel query. The rest of computation is dropped,
+     * and the result is deleted if already produced.
+     * @param[in] query_id query ID
+     * @return false if query is not found
+     */
+    bool cancel_query(const int32_t query_id);
+
+    /**
+     * Get counters of calculation
+     * @return counters
+     */
+    const CalcMetrics& metrics() const;
+
+    /**
+     * Delete results which have expired lifetime or exceed max total size.
+     * The result reaper thread calls this periodically.
      */
     void cleanup_results();
 
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_CALCSTAGE_HPP
+#define FTS_CS_CALCSTAGE_HPP
+
+#include <cstdint>
+#include <fts_share/fts_define.hpp>
+
+namespace fts_cs
+{
+
+/**
+ * @brief Enumeration for stages of the calculation pipeline.
+ */
+enum CalcStage_t : int32_t
+{
+    kCalcStageKeyFetch    = 0, // get keys and fit LUT
+    kCalcStageComputeA    = 1, // computationA
+    kCalcStageDecExchange = 2, // exchange intermediate results with decryptor
+    kCalcStageComputeB    = 3, // computationB
+    kNumOfCalcStages,
+};
+
+/**
+ * Get name of stage
+ * @param[in] stage stage
+ * @return name
+ */
+inline const char* calc_stage_name(const CalcStage_t stage)
+{
+    switch (stage) {
+        case kCalcStageKeyFetch:    return "key fetch";
+        case kCalcStageComputeA:    return "computationA";
+        case kCalcStageDecExchange: return "decryptor exchange";
+        case kCalcStageComputeB:    return "computationB";
+        default:                    return "unknown";
+    }
+}
+
+/**
+ * @brief This class is used to hold the num of threads of each stage.
+ */
+struct CalcStageThreads
+{
+    uint32_t key_fetch    = FTS_DEFAULT_KEYFETCH_THREADS;
+    uint32_t compute_a    = FTS_DEFAULT_COMPUTEA_THREADS;
+    uint32_t dec_exchange = FTS_DEFAULT_DECEXCHANGE_THREADS;
+    uint32_t compute_b    = FTS_DEFAULT_COMPUTEB_THREADS;
+
+    /**
+     * Get num of threads of stage
+     * @param[in] stage stage
+     * @return num of threads
+     */
+    uint32_t get(const CalcStage_t stage) const
+    {
+        switch (stage) {
+            case kCalcStageKeyFetch:    return key_fetch;
+            case kCalcStageComputeA:    return compute_a;
+            case kCalcStageDecExchange: return dec_exchange;
+            case kCalcStageComputeB:    return compute_b;
+            default:                    return 0;
+        }
+    }
+};
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_CALCSTAGE_HPP */
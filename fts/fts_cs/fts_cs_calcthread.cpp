@@ -1,344 +1,351 @@
 #include <unistd.h>
-#include <algorithm> // for sort
 #include <chrono>
-#include <random>
 #include <fstream>
 #include <sys/types.h>   // for thread id
 #include <sys/syscall.h> // for thread id
 #include <stdsc/stdsc_log.hpp>
-#include <omp.h>
 #include <fts_share/fts_seal_utility.hpp>
-#include <fts_share/fts_commonparam.hpp>
+#include <fts_share/fts_taskpool.hpp>
+#include <fts_share/fts_define.hpp>
+#include <fts_share/fts_random.hpp>
 #include <fts_share/fts_encdata.hpp>
 #include <fts_cs/fts_cs_query.hpp>
 #include <fts_cs/fts_cs_result.hpp>
 #include <fts_cs/fts_cs_calcthread.hpp>
 #include <fts_cs/fts_cs_dec_client.hpp>
+#include <fts_cs/fts_cs_dec_client_pool.hpp>
+#include <fts_cs/fts_cs_keycache.hpp>
+#include <fts_cs/fts_cs_lutgeometry.hpp>
+#include <fts_cs/fts_cs_bundlepool.hpp>
+#include <fts_cs/fts_cs_accumulator.hpp>
+#include <fts_cs/fts_cs_rotation.hpp>
+#include <fts_cs/fts_cs_metrics.hpp>
 #include <seal/seal.h>
 
 namespace fts_cs
 {
 
-unsigned g_seed = std::chrono::system_clock::now().time_since_epoch().count();
-std::mt19937 g_generator(g_seed);
-    
-static bool cmp(std::pair<int64_t, int64_t> a, std::pair<int64_t, int64_t> b)
-{
-    return a.second < b.second;
-}
-    
-static std::vector<int64_t> get_randomvector(int64_t total)
-{
-    std::vector<std::pair<int64_t, int64_t> > input;
-    std::vector<int64_t> output;
-    for (int64_t i=0; i<total; ++i) {
-        input.push_back({i, g_generator() % 1000000});
-    }
-    std::sort(input.begin(), input.end(), cmp);
-    for (int64_t i=0; i<total; ++i) {
-        output.push_back(input[i].first);
-    }
-    return output;
-}
-
+/**
+ * Make i-th row of the permuted output table for two input.
+ * The row is generated from the permutations on demand
+ * instead of materializing the whole permuted table.
+ */
 static void
-createLUTforOneInput(const std::vector<std::vector<int64_t>>& LUT,
-                     const std::vector<int64_t>& randomVector,
-                     std::vector<std::vector<int64_t>>& LUT_input,
-                     std::vector<std::vector<int64_t>>& LUT_output,
-                     const int64_t l, const int64_t k)
+createOutputRowforTwoInput(const int64_t i,
+                           const int64_t nx,
+                           const int64_t ny,
+                           const std::vector<int64_t>& table_out,
+                           const std::vector<int64_t>& vi_x,
+                           const std::vector<int64_t>& vi_y,
+                           const int64_t possible_input_num_two,
+                           const int64_t l,
+                           std::vector<int64_t>& row)
 {
-    std::vector<int64_t> sub_input;
-    std::vector<int64_t> sub_output;
-    int64_t total = randomVector.size();
-    int64_t row_size = l;
-    int64_t index = 0;
-
-    STDSC_LOG_INFO("create new LUT. (l:%ld, k:%ld, total:%ld)",
-                   l, k, total);
-    
-    for (int64_t i=0; i<k; ++i) {
-        for(int64_t j=0; j<row_size; ++j) {
-            int64_t s = randomVector[index];
-            int64_t temp_in = LUT[0][s];
-            sub_input.push_back(temp_in);
-            int64_t temp_out=LUT[1][s];
-            sub_output.push_back(temp_out);
-            ++index;
-        }
-        sub_input.resize(l);
-        LUT_input.push_back(sub_input);
-        sub_input.clear();
-        sub_output.resize(l);
-        LUT_output.push_back(sub_output);
-        sub_output.clear();
-    }
-}
-
-static void
-createLUTforTwoInput(const std::vector<int64_t>& table_x,
-                     const std::vector<int64_t>& table_y,
-                     const std::vector<int64_t>& table_out,
-                     const std::vector<int64_t>& vi_x,
-                     const std::vector<int64_t>& vi_y,
-                     const int64_t possible_input_num_two,
-                     std::vector<std::vector<int64_t>>& permute_table_x,
-                     std::vector<std::vector<int64_t>>& permute_table_y,
-                     std::vector<std::vector<int64_t>>& permute_out,
-                     const int64_t l,
-                     const int64_t k,
-                     const int64_t ks)
-{
-    std::vector<int64_t> per_x, per_y;
-    for (int i=0; i<possible_input_num_two; ++i) {
-        int64_t tempx = vi_x[i];
-        int64_t tempy = vi_y[i];
-        per_x.push_back(table_x[tempx]);
-        per_y.push_back(table_y[tempy]);
-    }
-
-    std::vector<int64_t> sub_per_x, sub_per_y;
-    for (int i=0; i<k; ++i) {
-        for (int j=0; j<l; ++j) {
-            sub_per_x.push_back(per_x[i * l + j]);
-            sub_per_y.push_back(per_y[i * l + j]);
-        }
-        permute_table_x.push_back(sub_per_x);
-        sub_per_x.clear();
-        permute_table_y.push_back(sub_per_y);
-        sub_per_y.clear();
-    }
-
-    std::vector<int64_t> per_out, sub_per_out;
-
-    for (int64_t h=0; h<possible_input_num_two; ++h) {
-        for(int64_t t=0; t<possible_input_num_two; ++t) {
-            int64_t tepx=vi_x[h];
-            int64_t tepy=vi_y[t];
-
-            per_out.push_back(table_out[tepx * possible_input_num_two + tepy]);
-        }
-    }
-
-    STDSC_LOG_INFO("Made permuted output vector.");
-
-    for (int i=0; i<ks; ++i) {
-        for(int j=0; j<l; ++j) {
-            sub_per_out.push_back(per_out[i * l + j]);
+    for (int64_t j=0; j<l; ++j) {
+        int64_t idx = i * l + j;
+        int64_t tepx = vi_x[idx / possible_input_num_two];
+        int64_t tepy = vi_y[idx % possible_input_num_two];
+
+        if (tepx < nx && tepy < ny) {
+            row[j] = table_out[tepx * ny + tepy];
+        } else {
+            row[j] = FTS_LUT_DUMMY_OUTPUT;
         }
-        permute_out.push_back(sub_per_out);
-        sub_per_out.clear();
     }
 }
-
-
     
 struct CalcThread::Impl
 {
-    Impl(QueryQueue& in_queue,
+    Impl(const CalcStage_t stage,
+         QueryQueue& in_queue,
+         CalcJobQueues& job_queues,
          ResultQueue& out_queue,
+         KeyCache& key_cache,
+         BundlePool& bundle_pool,
          std::vector<std::vector<int64_t>>& LUTin_one,
          std::vector<std::vector<int64_t>>& LUTin_two,
          std::vector<int64_t>& LUTout_two,
-         const int64_t possible_input_num_one,
-         const int64_t possible_input_num_two,
-         const int64_t possible_combination_num_two,
-         const std::string& dec_host,
-         const std::string& dec_port)
-        : in_queue_(in_queue),
+         DecClientPool& dec_pool,
+         CalcMetrics& metrics,
+         const EvalMode_t eval_mode,
+         const size_t max_query_bytes,
+         const int64_t packed_rows)
+        : stage_(stage),
+          in_queue_(in_queue),
+          job_queues_(job_queues),
           out_queue_(out_queue),
+          key_cache_(key_cache),
+          bundle_pool_(bundle_pool),
           LUTin_one_(LUTin_one),
           LUTin_two_(LUTin_two),
           LUTout_two_(LUTout_two),
-          possible_input_num_one_(possible_input_num_one),
-          possible_input_num_two_(possible_input_num_two),
-          possible_combination_num_two_(possible_combination_num_two),
-          dec_host_(dec_host),
-          dec_port_(dec_port)
+          dec_pool_(dec_pool),
+          metrics_(metrics),
+          eval_mode_(eval_mode),
+          max_query_bytes_(max_query_bytes),
+          packed_rows_(packed_rows)
     {
     }
 
     void exec(CalcThreadParam& args, std::shared_ptr<stdsc::ThreadException> te)
     {
-        auto th_id = syscall(SYS_gettid);
-        STDSC_LOG_INFO("Launched calcuration thread. (thread ID: %d)", th_id);
+        const int th_id = static_cast<int>(syscall(SYS_gettid));
+        STDSC_LOG_INFO("Launched calcuration thread of %s stage. (thread ID: %d)",
+                       calc_stage_name(stage_), th_id);
         
         while (!args.force_finish) {
 
-            STDSC_LOG_INFO("[th:%d] Try getting query from QueryQueue.", th_id);
-
-            int32_t query_id;
-            Query query;
-            while (!in_queue_.pop(query_id, query)) {
-                usleep(args.retry_interval_msec * 1000);
+            auto job = pop_job(args);
+            if (!job) {
+                continue;
             }
 
+            const int32_t query_id = job->query_id_;
             bool status = false;
-            
-            STDSC_LOG_INFO("[th:%d] Get query #%d.", th_id, query_id);
-
-            seal::PublicKey pubkey;
-            seal::GaloisKeys galoiskey;
-            seal::RelinKeys relinkey;
-            seal::EncryptionParameters params(seal::scheme_type::BFV);
-            STDSC_LOG_INFO("[th:%d] Start preprocess of query #%d.", th_id, query_id);
-            preprocess(query.key_id_, pubkey, galoiskey, relinkey, params);
-            STDSC_LOG_INFO("[th:%d] Finish preprocess of query #%d.", th_id, query_id);
-
-            seal::Ciphertext sum_result;
-            if (query.func_no_ == fts_share::kFuncTwo) {
-                seal::Ciphertext new_PIR_query0, new_PIR_query1, new_PIR_query2;
-                std::vector<std::vector<int64_t>> permute_out;
-                STDSC_LOG_INFO("[th:%d] Start computationA of query #%d.", th_id, query_id);
-                status = computeAforTwoInput(query_id, query,
-                                             pubkey, galoiskey, relinkey, params,
-                                             permute_out,
-                                             new_PIR_query0,
-                                             new_PIR_query1,
-                                             new_PIR_query2);
-                STDSC_LOG_INFO("[th:%d] Finish computationA of query #%d.", th_id, query_id);
-                
-                if (status) {
-                    STDSC_LOG_INFO("[th:%d] Start computationB of query #%d.", th_id, query_id);
-                    status = computeBforTwoInput(query_id, query,
-                                                 pubkey, galoiskey, relinkey, params,
-                                                 permute_out,
-                                                 new_PIR_query0,
-                                                 new_PIR_query1,
-                                                 new_PIR_query2,
-                                                 sum_result);
-                    STDSC_LOG_INFO("[th:%d] Finish computationB of query #%d.", th_id, query_id);
-                }
+
+            // Abandoned queries are dropped before each stage,
+            // including the round trip to decryptor.
+            if (drop_if_aborted(*job)) {
+                continue;
+            }
+
+            STDSC_LOG_INFO("[th:%d] Start %s of query #%d.", th_id, calc_stage_name(stage_), query_id);
+            auto start_time = std::chrono::system_clock::now();
+            try {
+                status = run_stage(*job);
+            } catch (stdsc::AbstractException& ex) {
+                STDSC_LOG_WARN("[th:%d] Failed %s of query #%d. (%s)",
+                               th_id, calc_stage_name(stage_), query_id, ex.what());
+            } catch (std::exception& ex) {
+                // SEAL throws standard exceptions, e.g. on malformed ciphertexts.
+                STDSC_LOG_WARN("[th:%d] Failed %s of query #%d. (%s)",
+                               th_id, calc_stage_name(stage_), query_id, ex.what());
+            }
+            auto elapsed_msec = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now() - start_time).count();
+            STDSC_LOG_INFO("[th:%d] Finish %s of query #%d. (%ld msec)",
+                           th_id, calc_stage_name(stage_), query_id, elapsed_msec);
+
+            if (drop_if_aborted(*job)) {
+                continue;
+            }
+            if (!status) {
+                Result result(query_id, false, seal::Ciphertext());
+                push_result(*job, result);
+                STDSC_LOG_INFO("[th:%d] Set failed result of query #%d.", th_id, query_id);
+            } else if (stage_ == kCalcStageComputeB) {
+                Result result(query_id, true, job->result_);
+                push_result(*job, result);
+                STDSC_LOG_INFO("[th:%d] Set result of query #%d.", th_id, query_id);
             } else {
-                seal::Ciphertext new_PIR_query, new_PIR_index;
-                std::vector<std::vector<int64_t>> LUT_output;
-                STDSC_LOG_INFO("[th:%d] Start computationA of query #%d.", th_id, query_id);
-                status = computeAforOneInput(query_id, query,
-                                             pubkey, galoiskey, relinkey, params,
-                                             LUT_output,
-                                             new_PIR_query,
-                                             new_PIR_index);
-                STDSC_LOG_INFO("[th:%d] Finish computationA of query #%d.", th_id, query_id);
-                
-                if (status) {
-                    STDSC_LOG_INFO("[th:%d] Start computationB of query #%d.", th_id, query_id);
-                    status = computeBforOneInput(query_id, query,
-                                                 pubkey, galoiskey, relinkey, params,
-                                                 LUT_output,
-                                                 new_PIR_query,
-                                                 new_PIR_index,
-                                                 sum_result);
-                    STDSC_LOG_INFO("[th:%d] Finish computationB of query #%d.", th_id, query_id);
+                auto next = static_cast<CalcStage_t>(stage_ + 1);
+                job_queues_[next].push(job->sched_, job);
+            }
+        }
+    }
+
+    std::shared_ptr<CalcJob> pop_job(const CalcThreadParam& args)
+    {
+        SchedEntry entry;
+        std::shared_ptr<CalcJob> job;
+
+        // The queues hand over queries in the order of scheduling policy.
+        if (stage_ == kCalcStageKeyFetch) {
+            Query query;
+            while (!in_queue_.wait_pop(entry, query, args.retry_interval_msec)) {
+                if (args.force_finish) {
+                    return nullptr;
                 }
             }
-                
-            Result result(query_id, status, sum_result);
-            out_queue_.push(query_id, result);
+            job = std::make_shared<CalcJob>();
+            job->query_id_ = entry.query_id;
+            job->query_    = query;
+            job->sched_    = entry;
+        } else {
+            while (!job_queues_[stage_].wait_pop(entry, job, args.retry_interval_msec)) {
+                if (args.force_finish) {
+                    return nullptr;
+                }
+            }
+        }
+        return job;
+    }
 
-            STDSC_LOG_INFO("[th:%d] Set result of query #%d.", th_id, query_id);
+    /**
+     * Drop the query if cancelled or expired. The failed result is set
+     * for expired queries so that the user is notified of them.
+     */
+    bool drop_if_aborted(const CalcJob& job)
+    {
+        if (job.is_cancelled()) {
+            auto n = ++metrics_.cancelled_queries;
+            STDSC_LOG_INFO("Dropped cancelled query #%d at %s stage. (cancelled queries: %lu)",
+                           job.query_id_, calc_stage_name(stage_), n);
+            return true;
+        }
+        if (job.is_expired()) {
+            auto n = ++metrics_.expired_queries;
+            STDSC_LOG_INFO("Dropped expired query #%d at %s stage. (expired queries: %lu)",
+                           job.query_id_, calc_stage_name(stage_), n);
+            Result result(job.query_id_, false, seal::Ciphertext());
+            push_result(job, result);
+            return true;
         }
+        return false;
     }
 
-    void preprocess(const int32_t key_id,
-                    seal::PublicKey& pubkey,
-                    seal::GaloisKeys& galoiskey,
-                    seal::RelinKeys& relinkey,
-                    seal::EncryptionParameters& params)
+    /**
+     * Push result. CalcManager::cancel_query sets the cancel flag and then
+     * deletes the result, so the flag is checked again after the push, and
+     * the result is deleted if the cancel request has missed it.
+     */
+    void push_result(const CalcJob& job, const Result& result)
     {
-        DecClient dec_client(dec_host_.c_str(), dec_port_.c_str());
-        dec_client.connect();
-        
-        dec_client.get_pubkey(key_id,    pubkey);
-        dec_client.get_galoiskey(key_id, galoiskey);
-        dec_client.get_relinkey(key_id,  relinkey);
-        dec_client.get_param(key_id,     params);
+        out_queue_.push(job.query_id_, result);
+        Result discarded;
+        if (job.is_cancelled() && out_queue_.pop(job.query_id_, discarded)) {
+            auto n = ++metrics_.cancelled_queries;
+            STDSC_LOG_INFO("Deleted the results of cancelled query #%d. (cancelled queries: %lu)",
+                           job.query_id_, n);
+        }
+    }
+
+    /**
+     * Check if the row is to be skipped since the query is abandoned
+     */
+    bool skip_row(const CalcJob& job)
+    {
+        if (job.is_aborted()) {
+            ++metrics_.dropped_rows;
+            return true;
+        }
+        return false;
+    }
+
+    bool run_stage(CalcJob& job)
+    {
+        switch (stage_) {
+            case kCalcStageKeyFetch:
+                return fetchKeys(job);
+            case kCalcStageComputeA:
+                return (job.query_.func_no_ == fts_share::kFuncTwo)
+                    ? computeAforTwoInput(job) : computeAforOneInput(job);
+            case kCalcStageDecExchange:
+                return exchangeWithDec(job);
+            case kCalcStageComputeB:
+                return computeB(job);
+            default:
+                STDSC_THROW_INVARIANT("Invalid stage.");
+        }
+    }
+
+    bool fetchKeys(CalcJob& job)
+    {
+        job.kctx_ = preprocess(job.query_.key_id_);
+
+        const int64_t row_size = job.kctx_->batch_encoder_->slot_count() / 2;
+        auto& geo = job.geo_;
+        if (job.query_.func_no_ == fts_share::kFuncTwo) {
+            geo = calcLUTGeometryForTwoInput(LUTin_two_[0].size(),
+                                             LUTin_two_[1].size(),
+                                             row_size);
+        } else {
+            geo = calcLUTGeometryForOneInput(LUTin_one_[0].size(), row_size, packed_rows_);
+        }
+        STDSC_LOG_INFO("LUT of query #%d is padded to %ld inputs. (l:%ld, k:%ld, ks:%ld, rows:%ld)",
+                       job.query_id_, geo.possible_input_num, geo.l, geo.k, geo.ks, geo.rows);
+        return true;
+    }
+
+    std::shared_ptr<const KeyContext> preprocess(const int32_t key_id)
+    {
+        auto kctx = key_cache_.get(key_id);
 
 #if defined ENABLE_LOCAL_DEBUG
         {
-            fts_share::seal_utility::write_to_file("pubkey.txt", pubkey);
-            fts_share::seal_utility::write_to_file("galoiskey.txt", galoiskey);
-            fts_share::seal_utility::write_to_file("relinkey.txt", relinkey);
-            fts_share::seal_utility::write_to_file("param.txt", params);
+            fts_share::seal_utility::write_to_file("pubkey.txt", kctx->pubkey_);
+            fts_share::seal_utility::write_to_file("galoiskey.txt", kctx->galoiskey_);
+            fts_share::seal_utility::write_to_file("relinkey.txt", kctx->relinkey_);
+            fts_share::seal_utility::write_to_file("param.txt", kctx->params_);
         }
 #endif
+        return kctx;
     }
     
-    bool computeAforOneInput(const int32_t query_id,
-                             const Query& query,
-                             const seal::PublicKey& pubkey,
-                             const seal::GaloisKeys& galoiskey,
-                             const seal::RelinKeys& relinkey,
-                             const seal::EncryptionParameters& params,
-                             std::vector<std::vector<int64_t>>& LUT_output,
-                             seal::Ciphertext& new_PIR_query,
-                             seal::Ciphertext& new_PIR_index)
+    /**
+     * Clear the masks of the padding slots, so that the padding entries
+     * are cancelled whatever the query is.
+     */
+    static void mask_padding(const LUTBundle& bundle, const size_t input, const int64_t row,
+                             std::vector<int64_t>& masks)
     {
-        DecClient dec_client(dec_host_.c_str(), dec_port_.c_str());
-        dec_client.connect();
+        for (auto slot : bundle.pad_slots_[input][row]) {
+            masks[slot] = 0;
+        }
+    }
 
-        auto& ciphertext_query = query.ctxts_[0];
-        auto context = seal::SEALContext::Create(params);
+    /**
+     * Set nonzero values on the padding slots, so that they never match.
+     */
+    static void add_padding(const LUTBundle& bundle, const size_t input, const int64_t row,
+                            seal::Evaluator& evaluator, seal::Ciphertext& ctxt)
+    {
+        if (!bundle.pad_slots_[input][row].empty()) {
+            evaluator.add_plain_inplace(ctxt, bundle.pad_rows_[input][row]);
+        }
+    }
 
-        seal::Evaluator evaluator(context);
-        seal::BatchEncoder batch_encoder(context);
+    bool computeAforOneInput(CalcJob& job)
+    {
+        const auto& query     = job.query_;
+        const auto& kctx      = *job.kctx_;
+        const auto& geo       = job.geo_;
+        auto& ciphertext_query = query.ctxts_[0];
+        const auto& params    = kctx.params_;
+        const auto& relinkey  = kctx.relinkey_;
+        auto& evaluator       = *kctx.evaluator_;
+        auto& batch_encoder   = *kctx.batch_encoder_;
         size_t slot_count = batch_encoder.slot_count();
         size_t row_size = slot_count / 2;
         std::cout << "  Plaintext matrix row size: " << row_size << std::endl;
         std::cout << "  Slot nums = " << slot_count << std::endl;
 
-        int64_t l = row_size;
-        int64_t k = ceil(possible_input_num_one_ / row_size);
-
-        std::vector<int64_t> vi = get_randomvector(possible_input_num_one_);
-        
-        std::vector<std::vector<int64_t>> LUT_input;
-        createLUTforOneInput(LUTin_one_, vi, LUT_input, LUT_output, l, k);
+        int64_t k = geo.k;
 
-#if defined ENABLE_LOCAL_DEBUG
-        //write shifted_output_table in a file
-        {
-            std::ofstream OutputTable;
-            OutputTable.open("queryt");
-            for(int i=0; i<k; ++i) {
-                for(int j=0; j<l; ++j) {
-                    OutputTable << LUT_output[i][j] <<' ';
-                }
-                OutputTable << std::endl;
-            }
-            OutputTable.close();
-        }
-#endif
+        job.bundle_ = bundle_pool_.pop(query.func_no_, params, geo);
+        const auto& poly_rows = job.bundle_->input_rows_[0];
 
         std::cout << "  Compute every row of table" << std::endl;
         
-        std::vector<seal::Ciphertext> Result;
-        for(int i=0; i<k; ++i) {
-            seal::Ciphertext tep;
-            Result.push_back(tep);
-        }
+        std::vector<seal::Ciphertext>& Result = job.midresults_x_;
+        Result.resize(k);
+
+        // Each row draws its masks from its own stream.
+        const auto stream_base = fts_share::RandomGenerator::new_stream_base();
 
-        omp_set_num_threads(FTS_COMMONPARAM_NTHREADS);
-        #pragma omp parallel for
-        for(int64_t i=0; i<k; ++i) {
+        fts_share::TaskPool::shared().parallel_for(0, k, [&](int64_t i) {
+            if (skip_row(job)) {
+                return;
+            }
             seal::Ciphertext res = ciphertext_query;
-            seal::Plaintext poly_row;
-            batch_encoder.encode(LUT_input[i], poly_row);
-            evaluator.sub_plain_inplace(res, poly_row);
+            evaluator.sub_plain_inplace(res, poly_rows[i]);
             evaluator.relinearize_inplace(res, relinkey);
 
+            // The masks cover every batching row that carries table entries,
+            // and the unused row is cleared.
+            fts_share::RandomGenerator rng(stream_base + i);
             std::vector<int64_t> random_value_vec;
-            for(size_t sk=0; sk<row_size; ++sk) {
-                int64_t random_value = (g_generator() % 5 + 1);
-                random_value_vec.push_back(random_value);
-            }
+            rng.fill_uniform(random_value_vec, row_size * geo.rows, 1, 5);
             random_value_vec.resize(slot_count);
+            mask_padding(*job.bundle_, 0, i, random_value_vec);
             seal::Plaintext poly_num;
             batch_encoder.encode(random_value_vec, poly_num);
 
             evaluator.multiply_plain_inplace(res, poly_num);
             evaluator.relinearize_inplace(res, relinkey);
+            add_padding(*job.bundle_, 0, i, evaluator, res);
             Result[i]=res;
-        }
+        });
 
 #if defined ENABLE_LOCAL_DEBUG
         {
@@ -353,170 +360,88 @@ struct CalcThread::Impl
         }
 #endif
 
-        std::cout << "  Send intermediate resutls to decryptor" << std::endl;
-        fts_share::EncData enc_midresult(params, Result);
-        fts_share::EncData enc_midresult_dummy(params);
-
-        fts_share::EncData enc_PIRquery(params);
-        auto res = dec_client.get_PIRquery(query.func_no_,
-                                           query.key_id_,
-                                           query_id, 
-                                           possible_input_num_one_,
-                                           possible_input_num_two_,
-                                           possible_combination_num_two_,
-                                           enc_midresult,
-                                           enc_midresult_dummy,
-                                           enc_PIRquery);
-
-        if (res != fts_share::kDecCalcResultSuccess) {
-            STDSC_LOG_WARN("  Failed to calcurate PIR queries on decryptor. (errno: %d)",
-                           static_cast<int32_t>(res));
-            return false;
-        }
-        
-        std::cout << "  Received PIR queries from decryptor" << std::endl;
-        
-#if defined ENABLE_LOCAL_DEBUG
-        {
-            auto& queryd = enc_PIRquery.data();
-            auto& queryi = enc_PIRindex.data();
-            fts_share::seal_utility::write_to_file("queryd", queryd);
-            fts_share::seal_utility::write_to_file("queryi", queryi);
-        }
-#endif
-
-        new_PIR_query = enc_PIRquery.vdata()[0];
-        new_PIR_index = enc_PIRquery.vdata()[1];
-
         return true;
     }
 
-    bool computeAforTwoInput(const int32_t query_id,
-                             const Query& query,
-                             const seal::PublicKey& pubkey,
-                             const seal::GaloisKeys& galoiskey,
-                             const seal::RelinKeys& relinkey,
-                             const seal::EncryptionParameters& params,
-                             std::vector<std::vector<int64_t>>& permute_out,
-                             seal::Ciphertext& new_PIR_query0,
-                             seal::Ciphertext& new_PIR_query1,
-                             seal::Ciphertext& new_PIR_query2)
+    bool computeAforTwoInput(CalcJob& job)
     {
+        const auto& query = job.query_;
         if (query.ctxts_.size() < 2) {
             STDSC_THROW_INVARIANT("Invalid input ciphertext number.");
         }
         
-        DecClient dec_client(dec_host_.c_str(), dec_port_.c_str());
-        dec_client.connect();
-
+        const auto& kctx      = *job.kctx_;
+        const auto& geo       = job.geo_;
         auto& ciphertext_x = query.ctxts_[0];
         auto& ciphertext_y = query.ctxts_[1];
-        auto context = seal::SEALContext::Create(params);
-
-        seal::Evaluator evaluator(context);
-        seal::BatchEncoder batch_encoder(context);
+        const auto& params    = kctx.params_;
+        const auto& relinkey  = kctx.relinkey_;
+        auto& evaluator       = *kctx.evaluator_;
+        auto& batch_encoder   = *kctx.batch_encoder_;
         size_t slot_count = batch_encoder.slot_count();
         size_t row_size = slot_count / 2;
         std::cout << "  Plaintext matrix row size: " << row_size << std::endl;
         std::cout << "  Slot nums = " << slot_count << std::endl;
 
-        int64_t l = row_size;
-        int64_t k = ceil(possible_input_num_two_ / row_size);
-        int64_t ks = ceil(possible_combination_num_two_ / row_size);
+        int64_t k = geo.k;
 
-        std::vector<int64_t> table_x, table_y, table_output;
-        for(int i=0; i<possible_input_num_two_; ++i){
-            table_x.push_back(LUTin_two_[0][i]);
-            table_y.push_back(LUTin_two_[1][i]);
-        }
+        job.bundle_ = bundle_pool_.pop(query.func_no_, params, geo);
+        const auto& poly_rows_x = job.bundle_->input_rows_[0];
+        const auto& poly_rows_y = job.bundle_->input_rows_[1];
 
-        std::vector<int64_t> vi_x = get_randomvector(possible_input_num_two_);
-        std::vector<int64_t> vi_y = get_randomvector(possible_input_num_two_);
-
-        std::vector<std::vector<int64_t>> permute_table_x, permute_table_y;
-        createLUTforTwoInput(table_x,
-                             table_y,
-                             LUTout_two_,
-                             vi_x,
-                             vi_y,
-                             possible_input_num_two_,
-                             permute_table_x,
-                             permute_table_y,
-                             permute_out,
-                             l, k, ks);
+        std::vector<seal::Ciphertext>& result_x = job.midresults_x_;
+        std::vector<seal::Ciphertext>& result_y = job.midresults_y_;
+        result_x.resize(k);
+        result_y.resize(k);
 
-#if defined ENABLE_LOCAL_DEBUG
-        //write shifted_output_table in a file
-        {
-            std::ofstream OutputTable;
-            OutputTable.open("query_table_out");
-            for(int i=0; i<ks; ++i) {
-                for(int j=0; j<l; ++j) {
-                    OutputTable << permute_out[i][j] <<' ';
-                }
-                OutputTable << std::endl;
-            }
-            OutputTable.close();
-        }
-#endif
-
-        std::vector<seal::Ciphertext> result_x, result_y;
-        for (int i=0; i<k; ++i) {
-            seal::Ciphertext tep;
-            result_x.push_back(tep);
-            result_y.push_back(tep);
-        }
+        // Each row of x and y draws its masks from its own stream.
+        const auto stream_base = fts_share::RandomGenerator::new_stream_base();
 
         //thread work
-        omp_set_num_threads(FTS_COMMONPARAM_NTHREADS);
-        #pragma omp parallel for
-        for (int64_t i=0; i<k; ++i) {
+        fts_share::TaskPool::shared().parallel_for(0, k, [&](int64_t i) {
+            if (skip_row(job)) {
+                return;
+            }
             seal::Ciphertext res_x = ciphertext_x;
-            seal::Plaintext poly_row_x;
-            permute_table_x[i].resize(slot_count);
-            batch_encoder.encode(permute_table_x[i], poly_row_x);
-            evaluator.sub_plain_inplace(res_x, poly_row_x);
+            evaluator.sub_plain_inplace(res_x, poly_rows_x[i]);
             evaluator.relinearize_inplace(res_x, relinkey);
 
+            fts_share::RandomGenerator rng_x(stream_base + 2 * i);
             std::vector<int64_t> random_value_vec1;
-            for (size_t sk=0; sk<row_size; ++sk) {
-                int64_t random_value=(g_generator() % 5 + 1);
-                random_value_vec1.push_back(random_value);
-            }
+            rng_x.fill_uniform(random_value_vec1, row_size, 1, 5);
             random_value_vec1.resize(slot_count);
+            mask_padding(*job.bundle_, 0, i, random_value_vec1);
             seal::Plaintext poly_num_x;
             batch_encoder.encode(random_value_vec1, poly_num_x);
 
             evaluator.multiply_plain_inplace(res_x, poly_num_x);
             evaluator.relinearize_inplace(res_x, relinkey);
+            add_padding(*job.bundle_, 0, i, evaluator, res_x);
             std::cout << "  Size after relinearization: " << res_x.size() << std::endl;
             std::cout << "  Noise budget after relinearizing (dbc = "
                       << relinkey.decomposition_bit_count() << std::endl;
             result_x[i]=res_x;
 
             seal::Ciphertext res_y = ciphertext_y;
-            seal::Plaintext poly_row_y;
-            permute_table_y[i].resize(slot_count);
-            batch_encoder.encode(permute_table_y[i], poly_row_y);
-            evaluator.sub_plain_inplace(res_y, poly_row_y);
+            evaluator.sub_plain_inplace(res_y, poly_rows_y[i]);
             evaluator.relinearize_inplace(res_y, relinkey);
 
+            fts_share::RandomGenerator rng_y(stream_base + 2 * i + 1);
             std::vector<int64_t> random_value_vec2;
-            for (size_t sk=0; sk<row_size; ++sk) {
-                int64_t random_value=(g_generator()%5+1);
-                random_value_vec2.push_back(random_value);
-            }
+            rng_y.fill_uniform(random_value_vec2, row_size, 1, 5);
             random_value_vec2.resize(slot_count);
+            mask_padding(*job.bundle_, 1, i, random_value_vec2);
             seal::Plaintext poly_num_y;
             batch_encoder.encode(random_value_vec2, poly_num_y);
 
             evaluator.multiply_plain_inplace(res_y, poly_num_y);
             evaluator.relinearize_inplace(res_y, relinkey);
+            add_padding(*job.bundle_, 1, i, evaluator, res_y);
             std::cout << "  Size after relinearization: " << res_y.size() << std::endl;
             std::cout << "  Noise budget after relinearizing (dbc = "
                       << relinkey.decomposition_bit_count() << std::endl;
             result_y[i]=res_y;
-        }
+        });
         
 #if defined ENABLE_LOCAL_DEBUG
         {
@@ -534,23 +459,40 @@ struct CalcThread::Impl
         }
 #endif
 
+        return true;
+    }
+
+    bool exchangeWithDec(CalcJob& job)
+    {
+        const auto& query  = job.query_;
+        const auto& geo    = job.geo_;
+        const auto& params = job.kctx_->params_;
+        const bool is_two  = (query.func_no_ == fts_share::kFuncTwo);
+
         std::cout << "  Send intermediate resutls to decryptor" << std::endl;
-        fts_share::EncData enc_midresult_x(params, result_x);
-        fts_share::EncData enc_midresult_y(params, result_y);
+        fts_share::EncData enc_midresult_x(params, job.midresults_x_);
+        fts_share::EncData enc_midresult_y(params, job.midresults_y_);
         fts_share::EncData enc_PIRquery(params);
-        auto res = dec_client.get_PIRquery(query.func_no_,
-                                           query.key_id_,
-                                           query_id, 
-                                           possible_input_num_one_,
-                                           possible_input_num_two_,
-                                           possible_combination_num_two_,
-                                           enc_midresult_x,
-                                           enc_midresult_y,
-                                           enc_PIRquery);
+        fts_share::DecCalcResult_t res = fts_share::kDecCalcResultNil;
+        dec_pool_.run([&](DecClient& dec_client) {
+            res = dec_client.get_PIRquery(query.func_no_,
+                                          query.key_id_,
+                                          job.query_id_,
+                                          is_two ? 0 : geo.possible_input_num,
+                                          is_two ? 1 : geo.rows,
+                                          is_two ? geo.possible_input_num : 0,
+                                          is_two ? geo.possible_combination_num : 0,
+                                          enc_midresult_x,
+                                          enc_midresult_y,
+                                          enc_PIRquery);
+        });
 
         if (res != fts_share::kDecCalcResultSuccess) {
             STDSC_LOG_WARN("  Failed to calcurate PIR queries on decryptor. (errno: %d)",
                            static_cast<int32_t>(res));
+            if (res == fts_share::kDecCalcResultErrNoFoundKeyID) {
+                key_cache_.erase(query.key_id_);
+            }
             return false;
         }
         
@@ -562,69 +504,98 @@ struct CalcThread::Impl
         }
 #endif
 
-        new_PIR_query0 = enc_PIRquery.vdata()[0];
-        new_PIR_query1 = enc_PIRquery.vdata()[1];
-        new_PIR_query2 = enc_PIRquery.vdata()[2];
+        // The intermediate results are no longer needed.
+        job.midresults_x_.clear();
+        job.midresults_y_.clear();
+        job.PIRqueries_ = enc_PIRquery.vdata();
 
         return true;
     }
+
+    bool computeB(CalcJob& job)
+    {
+        const auto& geo = job.geo_;
+        const auto& queries = job.PIRqueries_;
+        bool status;
+
+        auto start_time = std::chrono::system_clock::now();
+        if (job.query_.func_no_ == fts_share::kFuncTwo) {
+            status = computeBforTwoInput(job,
+                                         *job.kctx_,
+                                         geo,
+                                         *job.bundle_,
+                                         queries[0],
+                                         queries[1],
+                                         queries[2],
+                                         job.result_);
+        } else {
+            status = computeBforOneInput(job,
+                                         *job.kctx_,
+                                         geo,
+                                         *job.bundle_,
+                                         queries[0],
+                                         queries[1],
+                                         job.result_);
+        }
+        auto elapsed_msec = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now() - start_time).count();
+        STDSC_LOG_INFO("computationB of query #%d. (mode: %s, rows: %ld, %ld msec)",
+                       job.query_id_, eval_mode_name(eval_mode_of(job.query_.func_no_)),
+                       (job.query_.func_no_ == fts_share::kFuncTwo) ? geo.ks : geo.k,
+                       elapsed_msec);
+
+        return status;
+    }
     
-    bool computeBforOneInput(const int32_t query_id,
-                             const Query& query,
-                             const seal::PublicKey& pubkey,
-                             const seal::GaloisKeys& galoiskey,
-                             const seal::RelinKeys& relinkey,
-                             const seal::EncryptionParameters& params,
-                             const std::vector<std::vector<int64_t>>& LUT,
+    bool computeBforOneInput(const CalcJob& job,
+                             const KeyContext& kctx,
+                             const LUTGeometry& geo,
+                             const LUTBundle& bundle,
                              const seal::Ciphertext& new_PIR_query,
                              const seal::Ciphertext& new_PIR_index,
                              seal::Ciphertext& sum_result)
     {
-        auto context = seal::SEALContext::Create(params);
-
-        seal::Encryptor encryptor(context, pubkey);
-        seal::Evaluator evaluator(context);
-        seal::BatchEncoder batch_encoder(context);
+        const auto& galoiskey = kctx.galoiskey_;
+        const auto& relinkey  = kctx.relinkey_;
+        auto& evaluator       = *kctx.evaluator_;
+        auto& batch_encoder   = *kctx.batch_encoder_;
 
         size_t slot_count = batch_encoder.slot_count();
         size_t row_size = slot_count / 2;
         std::cout << "  Plaintext matrix row size: " << row_size << std::endl;
         std::cout << "  Slot nums = " << slot_count << std::endl;
 
-        int64_t k = ceil(possible_input_num_one_ / row_size);
+        int64_t k = geo.k;
 
         const seal::Ciphertext& new_query = new_PIR_query;
         const seal::Ciphertext& new_index = new_PIR_index;
 
+        // res[i] is new_index rotated by -i
         std::vector<seal::Ciphertext> res;
-        for (int i=0; i<k; ++i) {
-            seal::Ciphertext tep;
-            res.push_back(tep);
-        }
+        RotationEngine rotation(evaluator, galoiskey);
+        rotation.rotate_rows_series(new_index, 0, k, res);
 
-        std::vector<std::vector<int64_t>> tmpLUT(LUT.size());
-        std::copy(LUT.begin(), LUT.end(), tmpLUT.begin());
-        
-        omp_set_num_threads(FTS_COMMONPARAM_NTHREADS);
-        #pragma omp parallel for
-        for (int64_t i=0; i<k; ++i) {
-            tmpLUT[i].resize(slot_count);
-            seal::Plaintext poly_table_row;
-            batch_encoder.encode(tmpLUT[i], poly_table_row);
-            seal::Ciphertext temp = new_index;
-            evaluator.rotate_rows_inplace(temp, -i, galoiskey);
+        const auto& poly_table_rows = bundle.output_rows_;
+
+        fts_share::TaskPool::shared().parallel_for(0, k, [&](int64_t i) {
+            if (skip_row(job)) {
+                return;
+            }
+            // The products are kept unrelinearized (size 3)
+            // and relinearized once after accumulation.
+            seal::Ciphertext& temp = res[i];
             evaluator.multiply_inplace(temp, new_query);
-            evaluator.relinearize_inplace(temp, relinkey);
-            evaluator.multiply_plain_inplace(temp, poly_table_row);
-            evaluator.relinearize_inplace(temp, relinkey);
-            res[i]=temp;
+            if (eval_mode_ == kEvalModeNTT) {
+                // table rows are already in NTT form
+                evaluator.transform_to_ntt_inplace(temp);
+            }
+            evaluator.multiply_plain_inplace(temp, poly_table_rows[i]);
+        });
+        if (job.is_aborted()) {
+            return false;
         }
 
-        sum_result = res[0];
-        for(int i=1; i<k; ++i) {
-            evaluator.add_inplace(sum_result, res[i]);
-            evaluator.relinearize_inplace(sum_result, relinkey);
-        }
+        accumulate(evaluator, relinkey, res, sum_result);
 
 #if defined ENABLE_LOCAL_DEBUG
         //write Final_result in a file
@@ -641,85 +612,144 @@ struct CalcThread::Impl
         return true;
     }
 
-    bool computeBforTwoInput(const int32_t query_id,
-                             const Query& query,
-                             const seal::PublicKey& pubkey,
-                             const seal::GaloisKeys& galoiskey,
-                             const seal::RelinKeys& relinkey,
-                             const seal::EncryptionParameters& params,
-                             const std::vector<std::vector<int64_t>>& permute_out,
+    /**
+     * Calculate num of rows processed at once within the memory budget.
+     * At least one row per thread is processed if the budget allows,
+     * and at least one row in any case.
+     */
+    int64_t calc_chunk_rows(const int64_t ks,
+                            const size_t fixed_bytes,
+                            const size_t term_bytes) const
+    {
+        // reserve the running sum in addition to the fixed part
+        const size_t reserved = fixed_bytes + term_bytes;
+        int64_t rows = 1;
+        if (max_query_bytes_ > reserved) {
+            rows = std::max<int64_t>(1, (max_query_bytes_ - reserved) / term_bytes);
+        } else {
+            STDSC_LOG_WARN("Memory budget of query is too small. (budget: %lu bytes, required: %lu bytes)",
+                           max_query_bytes_, reserved + term_bytes);
+        }
+        return std::min<int64_t>(rows, ks);
+    }
+
+    bool computeBforTwoInput(const CalcJob& job,
+                             const KeyContext& kctx,
+                             const LUTGeometry& geo,
+                             const LUTBundle& bundle,
                              const seal::Ciphertext& new_PIR_query0,
                              const seal::Ciphertext& new_PIR_query1,
                              const seal::Ciphertext& new_PIR_query2,
                              seal::Ciphertext& sum_result)
     {
-        auto context = seal::SEALContext::Create(params);
-
-        seal::Encryptor encryptor(context, pubkey);
-        seal::Evaluator evaluator(context);
-        seal::BatchEncoder batch_encoder(context);
+        const auto& galoiskey = kctx.galoiskey_;
+        const auto& relinkey  = kctx.relinkey_;
+        auto& evaluator       = *kctx.evaluator_;
+        auto& batch_encoder   = *kctx.batch_encoder_;
 
         size_t slot_count = batch_encoder.slot_count();
         size_t row_size = slot_count / 2;
         std::cout << "  Plaintext matrix row size: " << row_size << std::endl;
         std::cout << "  Slot nums = " << slot_count << std::endl;
 
-        int64_t ks= ceil(possible_combination_num_two_ / row_size);
+        int64_t ks = geo.ks;
 
         const seal::Ciphertext& new_query0 = new_PIR_query0;
         const seal::Ciphertext& new_query1 = new_PIR_query1;
         const seal::Ciphertext& new_query2 = new_PIR_query2;
 
-        std::vector<seal::Ciphertext> query_rec, query_sub;
-        for (int i=0; i<ks; ++i) {
-            seal::Ciphertext temp_rec;
-            query_rec.push_back(temp_rec);
-        }
-        for (size_t i=0; i<row_size; ++i) {
-            seal::Ciphertext temp_sub;
-            query_sub.push_back(temp_sub);
-        }
+        // The second level loop touches only the first 'nss' blocks of query_sub.
+        const int64_t nss = (ks + row_size - 1) / row_size;
+        std::vector<seal::Ciphertext> query_sub;
+        RotationEngine rotation(evaluator, galoiskey);
 
         std::cout << "  First level threads work" << std::endl;
 
-        omp_set_num_threads(FTS_COMMONPARAM_NTHREADS);
-        #pragma omp parallel for
-        for (size_t i=0; i<row_size; ++i) {
-            seal::Ciphertext temp = new_query2;
-            evaluator.rotate_rows_inplace(temp, -i, galoiskey);
-            evaluator.multiply_inplace(temp, new_query1);
-            evaluator.relinearize_inplace(temp, relinkey);
-            query_sub[i] = temp;
-        }
+        rotation.rotate_rows_series(new_query2, 0, nss, query_sub);
+        fts_share::TaskPool::shared().parallel_for(0, nss, [&](int64_t i) {
+            if (skip_row(job)) {
+                return;
+            }
+            evaluator.multiply_inplace(query_sub[i], new_query1);
+            evaluator.relinearize_inplace(query_sub[i], relinkey);
+        });
+
+        // The second level rows are processed in chunks, so that the terms
+        // held at once fit in the memory budget of a query.
+        const size_t ctxt_poly_bytes = new_query0.poly_modulus_degree()
+            * new_query0.coeff_mod_count() * sizeof(uint64_t);
+        const size_t sub_bytes  = nss * 2 * ctxt_poly_bytes;
+        const size_t term_bytes = 3 * ctxt_poly_bytes;
+        const int64_t chunk_rows = calc_chunk_rows(ks, sub_bytes, term_bytes);
 
         std::cout << "  Second level threads work" << std::endl;
-        std::cout << "  ks:" << ks << std::endl;
+        std::cout << "  ks:" << ks << ", chunk rows:" << chunk_rows << std::endl;
 
-        std::vector<std::vector<int64_t>> tmp_permute_out(permute_out.size());
-        std::copy(permute_out.begin(), permute_out.end(), tmp_permute_out.begin());
+        const auto& vi_x = bundle.perms_[0];
+        const auto& vi_y = bundle.perms_[1];
+        const int64_t nx = LUTin_two_[0].size();
+        const int64_t ny = LUTin_two_[1].size();
         
-        omp_set_num_threads(FTS_COMMONPARAM_NTHREADS);
-        #pragma omp parallel for
-        for (int64_t i=0; i<ks; ++i) {
-            int64_t ss = i / row_size;
-            int64_t kk = i % row_size;
-            tmp_permute_out[i].resize(slot_count);
-            seal::Plaintext poly_table_row;
-            batch_encoder.encode(tmp_permute_out[i], poly_table_row);
-            seal::Ciphertext temp1 = query_sub[ss];
-            evaluator.rotate_rows_inplace(temp1, -kk, galoiskey);
-            evaluator.multiply_inplace(temp1, new_query0);
-            evaluator.relinearize_inplace(temp1, relinkey);
-            evaluator.multiply_plain_inplace(temp1, poly_table_row);
-            evaluator.relinearize_inplace(temp1, relinkey);
-            query_rec[i]=temp1;
-        }
+        std::vector<seal::Ciphertext> partial_sum(1);
+        size_t peak_bytes = 0;
+
+        for (int64_t begin=0; begin<ks; begin+=chunk_rows) {
+            if (job.is_aborted()) {
+                metrics_.dropped_rows += ks - begin;
+                return false;
+            }
+            const int64_t end = std::min<int64_t>(ks, begin + chunk_rows);
+            std::vector<seal::Ciphertext> query_rec(end - begin);
+
+            // query_rec[i - begin] is query_sub[i / row_size] rotated by -(i % row_size)
+            for (int64_t s=begin; s<end; ) {
+                const int64_t ss = s / static_cast<int64_t>(row_size);
+                const int64_t seg_begin = ss * row_size;
+                const int64_t seg_end = std::min<int64_t>(end, seg_begin + row_size);
+                std::vector<seal::Ciphertext> rotated;
+                rotation.rotate_rows_series(query_sub[ss], s - seg_begin, seg_end - seg_begin, rotated);
+                std::move(rotated.begin(), rotated.end(), query_rec.begin() + (s - begin));
+                s = seg_end;
+            }
+
+            fts_share::TaskPool::shared().parallel_for(begin, end, [&](int64_t i) {
+                if (skip_row(job)) {
+                    return;
+                }
+                std::vector<int64_t> table_row(slot_count, 0);
+                createOutputRowforTwoInput(i, nx, ny, LUTout_two_, vi_x, vi_y,
+                                           geo.possible_input_num, geo.l, table_row);
+                seal::Plaintext poly_table_row;
+                batch_encoder.encode(table_row, poly_table_row);
+                // The products are kept unrelinearized (size 3)
+                // and relinearized once after accumulation.
+                seal::Ciphertext& temp1 = query_rec[i - begin];
+                evaluator.multiply_inplace(temp1, new_query0);
+                evaluator.multiply_plain_inplace(temp1, poly_table_row);
+            });
+            if (job.is_aborted()) {
+                metrics_.dropped_rows += ks - end;
+                return false;
+            }
 
-        sum_result = query_rec[0];
-        for (int i=1; i<ks; ++i) {
-            evaluator.add_inplace(sum_result, query_rec[i]);
-            evaluator.relinearize_inplace(sum_result, relinkey);
+            size_t chunk_bytes = 0;
+            for (const auto& ctxt : query_rec) {
+                chunk_bytes += ctxt.uint64_count() * sizeof(uint64_t);
+            }
+            peak_bytes = std::max(peak_bytes, sub_bytes + chunk_bytes + (begin > 0 ? term_bytes : 0));
+
+            seal::Ciphertext chunk_sum;
+            tree_sum(evaluator, query_rec, chunk_sum);
+            if (begin == 0) {
+                partial_sum[0] = std::move(chunk_sum);
+            } else {
+                evaluator.add_inplace(partial_sum[0], chunk_sum);
+            }
         }
+
+        accumulate(evaluator, relinkey, partial_sum, sum_result);
+        STDSC_LOG_INFO("Peak memory of computationB for query #%d: %lu bytes (budget: %lu bytes, chunk rows: %ld)",
+                       job.query_id_, peak_bytes, max_query_bytes_, chunk_rows);
         std::cout << "  Size after relinearization: " << sum_result.size() << std::endl;
         std::cout << "  Noise budget after relinearizing (dbc = "
                   << relinkey.decomposition_bit_count() << std::endl;
@@ -740,35 +770,50 @@ struct CalcThread::Impl
     }
     
     
+    /**
+     * The output rows of two input are made per query, and transforming
+     * them to NTT form costs more than it saves, so two input is always
+     * evaluated in kEvalModeNormal.
+     */
+    EvalMode_t eval_mode_of(const fts_share::FuncNo_t func_no) const
+    {
+        return (func_no == fts_share::kFuncTwo) ? kEvalModeNormal : eval_mode_;
+    }
+
+    const CalcStage_t stage_;
     QueryQueue& in_queue_;
+    CalcJobQueues& job_queues_;
     ResultQueue& out_queue_;
+    KeyCache& key_cache_;
+    BundlePool& bundle_pool_;
     const std::vector<std::vector<int64_t>>& LUTin_one_;
     const std::vector<std::vector<int64_t>>& LUTin_two_;
     const std::vector<int64_t>& LUTout_two_;
-    const int64_t possible_input_num_one_;
-    const int64_t possible_input_num_two_;
-    const int64_t possible_combination_num_two_;
-    const std::string& dec_host_;
-    const std::string& dec_port_;
+    DecClientPool& dec_pool_;
+    CalcMetrics& metrics_;
+    const EvalMode_t eval_mode_;
+    const size_t max_query_bytes_;
+    const int64_t packed_rows_;
     CalcThreadParam param_;
     std::shared_ptr<stdsc::ThreadException> te_;
 };
 
-CalcThread::CalcThread(QueryQueue& in_queue,
+CalcThread::CalcThread(const CalcStage_t stage,
+                       QueryQueue& in_queue,
+                       CalcJobQueues& job_queues,
                        ResultQueue& out_queue,
+                       KeyCache& key_cache,
+                       BundlePool& bundle_pool,
                        std::vector<std::vector<int64_t>>& LUTin_one,
                        std::vector<std::vector<int64_t>>& LUTin_two,
                        std::vector<int64_t>& LUTout_two,
-                       const int64_t possible_input_num_one,
-                       const int64_t possible_input_num_two,
-                       const int64_t possible_combination_num_two,
-                       const std::string& dec_host,
-                       const std::string& dec_port)
-    : pimpl_(new Impl(in_queue, out_queue, LUTin_one, LUTin_two, LUTout_two, 
-                      possible_input_num_one,
-                      possible_input_num_two,
-                      possible_combination_num_two,
-                      dec_host, dec_port))
+                       DecClientPool& dec_pool,
+                       CalcMetrics& metrics,
+                       const EvalMode_t eval_mode,
+                       const size_t max_query_bytes,
+                       const int64_t packed_rows)
+    : pimpl_(new Impl(stage, in_queue, job_queues, out_queue, key_cache, bundle_pool, LUTin_one, LUTin_two, LUTout_two, 
+                      dec_pool, metrics, eval_mode, max_query_bytes, packed_rows))
 {}
 
 void CalcThread::start()
@@ -22,6 +22,9 @@
 #include <cstdbool>
 #include <vector>
 #include <stdsc/stdsc_thread.hpp>
+#include <fts_share/fts_define.hpp>
+#include <fts_cs/fts_cs_evalmode.hpp>
+#include <fts_cs/fts_cs_calcjob.hpp>
 
 namespace fts_cs
 {
@@ -29,9 +32,14 @@ namespace fts_cs
 class CalcThreadParam;
 class QueryQueue;
 class ResultQueue;
+class KeyCache;
+class BundlePool;
+class DecClientPool;
+struct CalcMetrics;
 
 /**
- * @brief Calculation thread
+ * @brief Calculation thread. Each thread runs one stage of the pipeline,
+ *        so that other queries are computed while a query waits on decryptor.
  */
 class CalcThread : public stdsc::Thread<CalcThreadParam>
 {
@@ -39,27 +47,35 @@ class CalcThread : public stdsc::Thread<CalcThreadParam>
 public:
     /**
      * Constructor
+     * @param[in] stage stage run by this thread
      * @param[in] in_queue query queue
+     * @param[in,out] job_queues input queues of stages
      * @param[out] out_queue result queue
+     * @param[in] key_cache key cache
+     * @param[in] bundle_pool LUT bundle pool
      * @param[in] LUTin_one  input LUT for one input
      * @param[in] LUTin_two  input LUT for two input
      * @param[in] LUTout_two output LUT for two input
-     * @param[in] possible_input_num_one num of possible inputs for one input
-     * @param[in] possible_input_num_two num of possible inputs for two input
-     * @param[in] possible_combination_num_two num of combination for one input
-     * @param[in] dec_host hostname of decryptor
-     * @param[in] dec_port port number of decryptor
+     * @param[in] dec_pool connection pool to decryptor
+     * @param[in,out] metrics counters of calculation
+     * @param[in] eval_mode evaluation mode of computationB
+     * @param[in] max_query_bytes memory budget of computationB per query (bytes)
+     * @param[in] packed_rows num of batching rows packed per ciphertext for one input (1 or 2)
      */
-    CalcThread(QueryQueue& in_queue,
+    CalcThread(const CalcStage_t stage,
+               QueryQueue& in_queue,
+               CalcJobQueues& job_queues,
                ResultQueue& out_queue,
+               KeyCache& key_cache,
+               BundlePool& bundle_pool,
                std::vector<std::vector<int64_t>>& LUTin_one,
                std::vector<std::vector<int64_t>>& LUTin_two,
                std::vector<int64_t>& LUTout_two,
-               const int64_t possible_input_num_one,
-               const int64_t possible_input_num_two,
-               const int64_t possible_combination_num_two,
-               const std::string& dec_host,
-               const std::string& dec_port);
+               DecClientPool& dec_pool,
+               CalcMetrics& metrics,
+               const EvalMode_t eval_mode = kEvalModeNTT,
+               const size_t max_query_bytes = FTS_DEFAULT_MAX_QUERY_BYTES,
+               const int64_t packed_rows = FTS_DEFAULT_PACKED_ROWS);
     virtual ~CalcThread(void) = default;
 
     /**
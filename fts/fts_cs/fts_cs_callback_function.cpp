@@ -17,11 +17,13 @@
 
 #include <iostream>
 #include <cstring>
+#include <algorithm>
 #include <stdsc/stdsc_buffer.hpp>
 #include <stdsc/stdsc_state.hpp>
 #include <stdsc/stdsc_socket.hpp>
 #include <stdsc/stdsc_packet.hpp>
 #include <stdsc/stdsc_exception.hpp>
+#include <fts_share/fts_define.hpp>
 #include <fts_share/fts_packet.hpp>
 #include <fts_share/fts_plaindata.hpp>
 #include <fts_share/fts_encdata.hpp>
@@ -40,6 +42,42 @@
 namespace fts_cs
 {
 
+/**
+ * Send result of query. The ciphertexts are sent only if succeeded.
+ */
+static void
+send_result(stdsc::Socket& sock,
+            const seal::EncryptionParameters& params,
+            const fts_share::CsCalcResult_t status,
+            const Result* result)
+{
+    fts_share::PlainData<fts_share::Cs2UserParam> splaindata;
+    fts_share::Cs2UserParam cs2userparam;
+    cs2userparam.result = status;
+    splaindata.push(cs2userparam);
+    
+    fts_share::EncData enc_outputs(params);
+    if (result) {
+        enc_outputs.push(result->ctxt_);
+    }
+#if defined ENABLE_LOCAL_DEBUG
+    if (result) {
+        fts_share::seal_utility::write_to_file("result.txt", enc_outputs.data());
+    }
+#endif
+    
+    auto sz = splaindata.stream_size() + enc_outputs.stream_size();
+    stdsc::BufferStream sbuffstream(sz);
+    std::iostream sstream(&sbuffstream);
+
+    splaindata.save_to_stream(sstream);
+    enc_outputs.save_to_stream(sstream);
+
+    stdsc::Buffer* bsbuff = &sbuffstream;
+    sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataResult, sz));
+    sock.send_buffer(*bsbuff);
+}
+
 // CallbackFunction for Query
 DEFUN_UPDOWNLOAD(CallbackFunctionQuery)
 {
@@ -68,19 +106,30 @@ DEFUN_UPDOWNLOAD(CallbackFunctionQuery)
     fts_share::seal_utility::write_to_file("query.txt", enc_inputs.data());
 #endif
 
-    Query query(user2csparam.key_id, user2csparam.func_no, enc_inputs.vdata());
-    int32_t query_id = calc_manager.push_query(query);
+    Query query(user2csparam.key_id, user2csparam.func_no, enc_inputs.vdata(),
+                user2csparam.deadline_msec);
+    uint32_t retry_after_msec;
+    int32_t query_id = calc_manager.push_query(query, retry_after_msec);
+
+    fts_share::PlainData<fts_share::Cs2UserParam> splaindata_status;
+    fts_share::Cs2UserParam cs2userparam;
+    cs2userparam.result = (query_id >= 0) ? fts_share::kCsCalcResultSuccess
+        : (retry_after_msec > 0) ? fts_share::kCsCalcResultRejected
+        : fts_share::kCsCalcResultFailed;
+    cs2userparam.retry_after_msec = retry_after_msec;
+    splaindata_status.push(cs2userparam);
 
     fts_share::PlainData<int32_t> splaindata;
     splaindata.push(query_id);
 
-    auto sz = splaindata.stream_size();
+    auto sz = splaindata_status.stream_size() + splaindata.stream_size();
     stdsc::BufferStream sbuffstream(sz);
     std::iostream sstream(&sbuffstream);
 
+    splaindata_status.save_to_stream(sstream);
     splaindata.save_to_stream(sstream);
 
-    STDSC_LOG_INFO("Sending query ack. (query ID: %d)", query_id);
+    STDSC_LOG_INFO("Sending query ack. (query ID: %d, retry after: %u msec)", query_id, retry_after_msec);
     stdsc::Buffer* bsbuff = &sbuffstream;
     sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataQueryID, sz));
     sock.send_buffer(*bsbuff);
@@ -109,30 +158,96 @@ DEFUN_UPDOWNLOAD(CallbackFunctionResultRequest)
     params = seal::EncryptionParameters::Load(rstream);
 
     Result result;
-    calc_manager.pop_result(query_id, result);
+    if (!calc_manager.pop_result(query_id, result)) {
+        STDSC_LOG_INFO("Sending not found. (query ID: %d)", query_id);
+        send_result(sock, params, fts_share::kCsCalcResultNotFound, nullptr);
+        state.set(kEventResultRequest);
+        return;
+    }
 
-    fts_share::PlainData<fts_share::Cs2UserParam> splaindata;
-    fts_share::Cs2UserParam cs2userparam;
-    cs2userparam.result = result.status_ ? fts_share::kCsCalcResultSuccess : fts_share::kCsCalcResultFailed;
-    splaindata.push(cs2userparam);
-    
-    fts_share::EncData enc_outputs(params, result.ctxt_);
-#if defined ENABLE_LOCAL_DEBUG
-    fts_share::seal_utility::write_to_file("result.txt", enc_outputs.data());
-#endif
-    
-    auto sz = splaindata.stream_size() + enc_outputs.stream_size();
+    STDSC_LOG_INFO("Sending result. (query ID: %d)", query_id);
+    if (result.status_) {
+        send_result(sock, params, fts_share::kCsCalcResultSuccess, &result);
+    } else {
+        send_result(sock, params, fts_share::kCsCalcResultFailed, nullptr);
+    }
+    state.set(kEventResultRequest);
+}
+
+// CallbackFunction for Result Poll Request
+DEFUN_UPDOWNLOAD(CallbackFunctionResultPollRequest)
+{
+    STDSC_LOG_INFO("Received result poll request. (current state : %s)",
+                   state.current_state_str().c_str());
+
+    DEF_CDATA_ON_ALL(fts_cs::CommonCallbackParam);
+    auto& calc_manager = cdata_a->calc_manager_;
+
+    stdsc::BufferStream rbuffstream(buffer);
+    std::iostream rstream(&rbuffstream);
+
+    // load plaindata (param)
+    fts_share::PlainData<fts_share::User2CsPollParam> rplaindata;
+    rplaindata.load_from_stream(rstream);
+    const auto& pollparam = rplaindata.data();
+    const auto query_id = pollparam.query_id;
+
+    // load encryption parameters
+    seal::EncryptionParameters params(seal::scheme_type::BFV);
+    params = seal::EncryptionParameters::Load(rstream);
+
+    // The server thread is held at most FTS_MAX_RESULT_POLL_MSEC.
+    const uint32_t timeout_msec = std::min<uint32_t>(pollparam.timeout_msec,
+                                                     FTS_MAX_RESULT_POLL_MSEC);
+    Result result;
+    const auto status = calc_manager.poll_result(query_id, result, timeout_msec);
+    if (status == fts_share::kCsCalcResultPending) {
+        STDSC_LOG_TRACE("Sending pending. (query ID: %d)", query_id);
+        send_result(sock, params, status, nullptr);
+    } else if (status == fts_share::kCsCalcResultNotFound) {
+        STDSC_LOG_INFO("Sending not found. (query ID: %d)", query_id);
+        send_result(sock, params, status, nullptr);
+    } else {
+        STDSC_LOG_INFO("Sending result. (query ID: %d)", query_id);
+        send_result(sock, params, status,
+                    (status == fts_share::kCsCalcResultSuccess) ? &result : nullptr);
+    }
+    state.set(kEventResultRequest);
+}
+
+// CallbackFunction for Cancel Request
+DEFUN_UPDOWNLOAD(CallbackFunctionCancelRequest)
+{
+    STDSC_LOG_INFO("Received cancel request. (current state : %s)",
+                   state.current_state_str().c_str());
+
+    DEF_CDATA_ON_ALL(fts_cs::CommonCallbackParam);
+    auto& calc_manager = cdata_a->calc_manager_;
+
+    stdsc::BufferStream rbuffstream(buffer);
+    std::iostream rstream(&rbuffstream);
+
+    // load plaindata (param)
+    fts_share::PlainData<int32_t> rplaindata;
+    rplaindata.load_from_stream(rstream);
+    const auto query_id = rplaindata.data();
+
+    const int32_t found = calc_manager.cancel_query(query_id) ? 1 : 0;
+
+    fts_share::PlainData<int32_t> splaindata;
+    splaindata.push(found);
+
+    auto sz = splaindata.stream_size();
     stdsc::BufferStream sbuffstream(sz);
     std::iostream sstream(&sbuffstream);
 
     splaindata.save_to_stream(sstream);
-    enc_outputs.save_to_stream(sstream);
 
-    STDSC_LOG_INFO("Sending result. (query ID: %d)", query_id);
+    STDSC_LOG_INFO("Sending cancel ack. (query ID: %d, found: %d)", query_id, found);
     stdsc::Buffer* bsbuff = &sbuffstream;
-    sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataResult, sz));
+    sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataCancelAck, sz));
     sock.send_buffer(*bsbuff);
-    state.set(kEventResultRequest);
+    state.set(kEventCancelRequest);
 }
 
 } /* namespace fts_cs */
@@ -33,6 +33,17 @@ DECLARE_UPDOWNLOAD_CLASS(CallbackFunctionQuery);
  */
 DECLARE_UPDOWNLOAD_CLASS(CallbackFunctionResultRequest);
 
+/**
+ * @brief Provides callback function in receiving result poll request.
+ *        Returns pending if the result is not produced within timeout.
+ */
+DECLARE_UPDOWNLOAD_CLASS(CallbackFunctionResultPollRequest);
+
+/**
+ * @brief Provides callback function in receiving cancel request.
+ */
+DECLARE_UPDOWNLOAD_CLASS(CallbackFunctionCancelRequest);
+
 } /* namespace fts_cs */
 
 #endif /* FTS_CS_SRV_CALLBACK_FUNCTION_HPP */
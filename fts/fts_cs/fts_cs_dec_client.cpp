@@ -44,6 +44,19 @@ public:
         client_.close();
     }
 
+    void ping(void)
+    {
+        client_.send_request_blocking(fts_share::kControlCodeRequestPing);
+    }
+
+    bool is_exist_key(const int32_t key_id)
+    {
+        stdsc::Buffer sbuffer(sizeof(key_id)), rbuffer;
+        *(int32_t*)sbuffer.data() = key_id;
+        client_.send_recv_data_blocking(fts_share::kControlCodeUpDownloadKeyCheck, sbuffer, rbuffer);
+        return *static_cast<const int32_t*>(rbuffer.data()) != 0;
+    }
+
     template <class T>
     void get_key(const int32_t key_id, const fts_share::ControlCode_t code, T& key)
     {
@@ -72,6 +85,7 @@ public:
                  const int32_t key_id,
                  const int32_t query_id,
                  const int64_t possible_input_num_one,
+                 const int64_t packed_rows_one,
                  const int64_t possible_input_num_two,
                  const int64_t possible_combination_num_two,
                  const fts_share::EncData& enc_midresult_x,
@@ -84,6 +98,7 @@ public:
                key_id,
                query_id,
                possible_input_num_one,
+               packed_rows_one,
                possible_input_num_two,
                possible_combination_num_two};
         splaindata.push(param);
@@ -144,6 +159,18 @@ void DecClient::disconnect(void)
     pimpl_->disconnect();
 }
 
+void DecClient::ping(void)
+{
+    STDSC_LOG_TRACE("Ping to decryptor.");
+    pimpl_->ping();
+}
+
+bool DecClient::is_exist_key(const int32_t key_id)
+{
+    STDSC_LOG_TRACE("Check key ID on decryptor. (key ID: %d)", key_id);
+    return pimpl_->is_exist_key(key_id);
+}
+
 void DecClient::get_pubkey(const int32_t key_id, seal::PublicKey& pubkey)
 {
     STDSC_LOG_INFO("Get public key: sending request of #%d to decryptor.", key_id);
@@ -176,6 +203,7 @@ fts_share::DecCalcResult_t DecClient::get_PIRquery(const fts_share::FuncNo_t fun
                                                    const int32_t key_id,
                                                    const int32_t query_id,
                                                    const int64_t possible_input_num_one,
+                                                   const int64_t packed_rows_one,
                                                    const int64_t possible_input_num_two,
                                                    const int64_t possible_combination_num_two,
                                                    const fts_share::EncData& enc_midresult_x,
@@ -187,6 +215,7 @@ fts_share::DecCalcResult_t DecClient::get_PIRquery(const fts_share::FuncNo_t fun
                                 key_id,
                                 query_id,
                                 possible_input_num_one,
+                                packed_rows_one,
                                 possible_input_num_two,
                                 possible_combination_num_two,
                                 enc_midresult_x,
@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <fts_share/fts_define.hpp>
+#include <fts_share/fts_funcno.hpp>
 #include <fts_share/fts_dec2csparam.hpp>
 #include <seal/seal.h>
 
@@ -58,6 +59,18 @@ public:
      */
     void disconnect();
 
+    /**
+     * Check that the connection is alive
+     */
+    void ping();
+
+    /**
+     * Check that the keys of key ID are held by decryptor
+     * @param[in] key_id key ID
+     * @return true if the keys exist
+     */
+    bool is_exist_key(const int32_t key_id);
+
     /**
      * Get public key from decryptor
      * @param[in]  key_id key ID
@@ -92,6 +105,7 @@ public:
      * @param[in] key_id key ID
      * @parma[in] query_id query ID
      * @param[in] possible_input_num_one num of possible inputs for one input
+     * @param[in] packed_rows_one num of batching rows packed per ciphertext for one input
      * @param[in] possible_input_num_two num of possible inputs for two input
      * @param[in] possible_combination_num_two num of combination for one input
      * @param[in] enc_midresult_x intermediate results
@@ -104,6 +118,7 @@ public:
                  const int32_t key_id,
                  const int32_t query_id,
                  const int64_t possible_input_num_one,
+                 const int64_t packed_rows_one,
                  const int64_t possible_input_num_two,
                  const int64_t possible_combination_num_two,
                  const fts_share::EncData& enc_midresult_x,
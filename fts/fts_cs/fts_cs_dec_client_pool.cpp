@@ -0,0 +1,158 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <condition_variable>
+#include <stdsc/stdsc_log.hpp>
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_cs/fts_cs_dec_client.hpp>
+#include <fts_cs/fts_cs_dec_client_pool.hpp>
+
+namespace fts_cs
+{
+
+#define DECCLIENTPOOL_MAX_ATTEMPTS (2)
+
+struct DecClientPool::Impl
+{
+    struct Conn
+    {
+        size_t index;
+        bool connected;
+        std::shared_ptr<DecClient> client;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    Impl(const std::string& dec_host,
+         const std::string& dec_port,
+         const size_t max_clients,
+         const uint32_t health_check_interval_sec)
+        : dec_host_(dec_host),
+          dec_port_(dec_port),
+          health_check_interval_(health_check_interval_sec)
+    {
+        STDSC_THROW_INVPARAM_IF_CHECK(max_clients > 0, "max number of connections must be positive");
+        for (size_t i=0; i<max_clients; ++i) {
+            auto conn = std::make_shared<Conn>();
+            conn->index     = i;
+            conn->connected = false;
+            conn->client    = std::make_shared<DecClient>(dec_host_.c_str(), dec_port_.c_str());
+            idle_.push_back(conn);
+        }
+    }
+
+    void run(const Task& task)
+    {
+        auto conn = acquire();
+        for (int32_t attempt=1; ; ++attempt) {
+            try {
+                prepare(*conn);
+                task(*conn->client);
+                break;
+            } catch (stdsc::AbstractException& ex) {
+                reset(*conn);
+                if (attempt >= DECCLIENTPOOL_MAX_ATTEMPTS) {
+                    release(conn);
+                    throw;
+                }
+                STDSC_LOG_WARN("Connection #%lu to decryptor failed. Reconnecting. (%s)",
+                               conn->index, ex.what());
+            } catch (...) {
+                reset(*conn);
+                release(conn);
+                throw;
+            }
+        }
+        conn->last_used = std::chrono::steady_clock::now();
+        release(conn);
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto& conn : idle_) {
+            reset(*conn);
+        }
+    }
+
+private:
+    std::shared_ptr<Conn> acquire()
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cond_.wait(lock, [this]{ return !idle_.empty(); });
+        // the most recently used connection is leased first,
+        // so that idle ones are rarely woken up.
+        auto conn = idle_.back();
+        idle_.pop_back();
+        return conn;
+    }
+
+    void release(const std::shared_ptr<Conn>& conn)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        idle_.push_back(conn);
+        cond_.notify_one();
+    }
+
+    void prepare(Conn& conn)
+    {
+        if (!conn.connected) {
+            STDSC_LOG_INFO("Open connection #%lu to decryptor.", conn.index);
+            conn.client->connect();
+            conn.connected = true;
+        } else if (std::chrono::steady_clock::now() - conn.last_used > health_check_interval_) {
+            conn.client->ping();
+        }
+    }
+
+    void reset(Conn& conn)
+    {
+        // The client is rebuilt so that the broken socket is closed.
+        conn.client    = std::make_shared<DecClient>(dec_host_.c_str(), dec_port_.c_str());
+        conn.connected = false;
+    }
+
+    const std::string dec_host_;
+    const std::string dec_port_;
+    const std::chrono::seconds health_check_interval_;
+    std::deque<std::shared_ptr<Conn>> idle_;
+    std::mutex mtx_;
+    std::condition_variable cond_;
+};
+
+DecClientPool::DecClientPool(const std::string& dec_host,
+                             const std::string& dec_port,
+                             const size_t max_clients,
+                             const uint32_t health_check_interval_sec)
+    : pimpl_(new Impl(dec_host, dec_port, max_clients, health_check_interval_sec))
+{
+}
+
+void DecClientPool::run(const Task& task)
+{
+    pimpl_->run(task);
+}
+
+void DecClientPool::close()
+{
+    pimpl_->close();
+}
+
+} /* namespace fts_cs */
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_DEC_CLIENT_POOL_HPP
+#define FTS_CS_DEC_CLIENT_POOL_HPP
+
+#include <memory>
+#include <string>
+#include <functional>
+#include <fts_share/fts_define.hpp>
+
+namespace fts_cs
+{
+
+class DecClient;
+
+/**
+ * @brief Provides the pool of persistent connections to Decryptor shared by
+ *        calculation threads. A connection is leased to one request at a time,
+ *        checked by ping if it has been idle, and reconnected on failure.
+ */
+class DecClientPool
+{
+public:
+    using Task = std::function<void(DecClient&)>;
+
+    /**
+     * Constructor
+     * @param[in] dec_host hostname of decryptor
+     * @param[in] dec_port port number of decryptor
+     * @param[in] max_clients max number of connections
+     * @param[in] health_check_interval_sec idle time to check connection before use (sec)
+     */
+    DecClientPool(const std::string& dec_host,
+                  const std::string& dec_port,
+                  const size_t max_clients,
+                  const uint32_t health_check_interval_sec = FTS_DEC_HEALTH_CHECK_INTERVAL_SEC);
+    virtual ~DecClientPool(void) = default;
+
+    /**
+     * Run task with a leased connection. This function blocks while
+     * all connections are in use. The task is retried once with a new
+     * connection if the connection fails.
+     * @param[in] task task
+     */
+    void run(const Task& task);
+
+    /**
+     * Close all idle connections
+     */
+    void close();
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> pimpl_;
+};
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_DEC_CLIENT_POOL_HPP */
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_EVALMODE_HPP
+#define FTS_CS_EVALMODE_HPP
+
+#include <cstdint>
+
+namespace fts_cs
+{
+
+/**
+ * @brief Enumeration for evaluation mode of plaintext multiplication in computationB.
+ */
+enum EvalMode_t : int32_t
+{
+    kEvalModeNormal = 0, // multiply with plaintexts in normal form
+    kEvalModeNTT    = 1, // multiply with plaintexts pre-transformed to NTT form,
+                         // and accumulate ciphertexts in NTT form (one input only,
+                         // two input falls back to kEvalModeNormal)
+};
+
+/**
+ * Get name of evaluation mode
+ * @param[in] mode evaluation mode
+ * @return name
+ */
+inline const char* eval_mode_name(const EvalMode_t mode)
+{
+    return (mode == kEvalModeNTT) ? "ntt" : "normal";
+}
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_EVALMODE_HPP */
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <list>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdsc/stdsc_log.hpp>
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_cs/fts_cs_dec_client.hpp>
+#include <fts_cs/fts_cs_dec_client_pool.hpp>
+#include <fts_cs/fts_cs_keycache.hpp>
+
+namespace fts_cs
+{
+
+static size_t ciphertext_bytes(const seal::Ciphertext& ctxt)
+{
+    return ctxt.uint64_count() * sizeof(uint64_t);
+}
+
+template <class T>
+static size_t kswitchkeys_bytes(const T& keys)
+{
+    size_t sz = 0;
+    for (const auto& vec : keys.data()) {
+        for (const auto& ctxt : vec) {
+            sz += ciphertext_bytes(ctxt);
+        }
+    }
+    return sz;
+}
+
+// KeyContext
+KeyContext::KeyContext(const seal::PublicKey& pubkey,
+                       const seal::GaloisKeys& galoiskey,
+                       const seal::RelinKeys& relinkey,
+                       const seal::EncryptionParameters& params)
+    : pubkey_(pubkey),
+      galoiskey_(galoiskey),
+      relinkey_(relinkey),
+      params_(params)
+{
+    context_       = seal::SEALContext::Create(params_);
+    evaluator_     = std::make_shared<seal::Evaluator>(context_);
+    batch_encoder_ = std::make_shared<seal::BatchEncoder>(context_);
+}
+
+size_t KeyContext::data_size() const
+{
+    return ciphertext_bytes(pubkey_.data())
+        + kswitchkeys_bytes(galoiskey_)
+        + kswitchkeys_bytes(relinkey_);
+}
+
+// KeyCache
+struct KeyCache::Impl
+{
+    struct Entry
+    {
+        std::shared_ptr<const KeyContext> kctx;
+        std::list<int32_t>::iterator lru_pos;
+        size_t bytes;
+    };
+
+    Impl(DecClientPool& dec_pool,
+         const size_t max_entries,
+         const size_t max_bytes)
+        : dec_pool_(dec_pool),
+          max_entries_(max_entries),
+          max_bytes_(max_bytes),
+          total_bytes_(0)
+    {
+    }
+
+    std::shared_ptr<const KeyContext> get(const int32_t key_id)
+    {
+        // The keys may have been deleted on decryptor since they were cached.
+        bool exists = false;
+        dec_pool_.run([&](DecClient& dec_client) {
+            exists = dec_client.is_exist_key(key_id);
+        });
+
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (!exists) {
+            remove(key_id);
+            STDSC_THROW_INVPARAM("key ID is not found on decryptor.");
+        }
+
+        // wait if the other thread is downloading the same keys
+        while (true) {
+            auto it = map_.find(key_id);
+            if (it != map_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+                return it->second.kctx;
+            }
+            if (!loading_.count(key_id)) {
+                break;
+            }
+            cond_.wait(lock);
+        }
+        loading_.insert(key_id);
+        lock.unlock();
+
+        std::shared_ptr<const KeyContext> kctx;
+        try {
+            kctx = load(key_id);
+        } catch (...) {
+            lock.lock();
+            loading_.erase(key_id);
+            cond_.notify_all();
+            throw;
+        }
+
+        lock.lock();
+        loading_.erase(key_id);
+
+        lru_.push_front(key_id);
+        Entry entry = {kctx, lru_.begin(), kctx->data_size()};
+        total_bytes_ += entry.bytes;
+        map_.emplace(key_id, entry);
+        STDSC_LOG_INFO("Cached evaluation context of key #%d. (%lu bytes, total: %lu bytes)",
+                       key_id, entry.bytes, total_bytes_);
+
+        evict();
+        cond_.notify_all();
+        return kctx;
+    }
+
+    void erase(const int32_t key_id)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        remove(key_id);
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return map_.size();
+    }
+
+private:
+    std::shared_ptr<const KeyContext> load(const int32_t key_id)
+    {
+        seal::PublicKey pubkey;
+        seal::GaloisKeys galoiskey;
+        seal::RelinKeys relinkey;
+        seal::EncryptionParameters params(seal::scheme_type::BFV);
+
+        dec_pool_.run([&](DecClient& dec_client) {
+            dec_client.get_pubkey(key_id,    pubkey);
+            dec_client.get_galoiskey(key_id, galoiskey);
+            dec_client.get_relinkey(key_id,  relinkey);
+            dec_client.get_param(key_id,     params);
+        });
+
+        return std::make_shared<const KeyContext>(pubkey, galoiskey, relinkey, params);
+    }
+
+    void remove(const int32_t key_id)
+    {
+        auto it = map_.find(key_id);
+        if (it == map_.end()) {
+            return;
+        }
+        total_bytes_ -= it->second.bytes;
+        lru_.erase(it->second.lru_pos);
+        map_.erase(it);
+        STDSC_LOG_INFO("Discarded evaluation context of key #%d.", key_id);
+    }
+
+    void evict()
+    {
+        // the most recently used context is always kept
+        while (map_.size() > 1 &&
+               (map_.size() > max_entries_ || total_bytes_ > max_bytes_)) {
+            remove(lru_.back());
+        }
+    }
+
+    DecClientPool& dec_pool_;
+    const size_t max_entries_;
+    const size_t max_bytes_;
+    size_t total_bytes_;
+    std::list<int32_t> lru_;
+    std::unordered_map<int32_t, Entry> map_;
+    std::unordered_set<int32_t> loading_;
+    mutable std::mutex mtx_;
+    std::condition_variable cond_;
+};
+
+KeyCache::KeyCache(DecClientPool& dec_pool,
+                   const size_t max_entries,
+                   const size_t max_bytes)
+    : pimpl_(new Impl(dec_pool, max_entries, max_bytes))
+{
+}
+
+std::shared_ptr<const KeyContext> KeyCache::get(const int32_t key_id)
+{
+    return pimpl_->get(key_id);
+}
+
+void KeyCache::erase(const int32_t key_id)
+{
+    pimpl_->erase(key_id);
+}
+
+size_t KeyCache::size() const
+{
+    return pimpl_->size();
+}
+
+} /* namespace fts_cs */
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_KEYCACHE_HPP
+#define FTS_CS_KEYCACHE_HPP
+
+#include <memory>
+#include <string>
+#include <seal/seal.h>
+
+namespace fts_cs
+{
+
+class DecClientPool;
+
+/**
+ * @brief This class is used to hold the evaluation context of a key ID.
+ */
+struct KeyContext
+{
+    /**
+     * Constructor
+     * @param[in] pubkey    public key
+     * @param[in] galoiskey galois keys
+     * @param[in] relinkey  relin keys
+     * @param[in] params    encryption parameters
+     */
+    KeyContext(const seal::PublicKey& pubkey,
+               const seal::GaloisKeys& galoiskey,
+               const seal::RelinKeys& relinkey,
+               const seal::EncryptionParameters& params);
+    virtual ~KeyContext() = default;
+
+    /**
+     * Get data size of keys
+     * @return data size (bytes)
+     */
+    size_t data_size() const;
+
+    seal::PublicKey pubkey_;
+    seal::GaloisKeys galoiskey_;
+    seal::RelinKeys relinkey_;
+    seal::EncryptionParameters params_;
+    std::shared_ptr<seal::SEALContext> context_;
+    std::shared_ptr<seal::Evaluator> evaluator_;
+    std::shared_ptr<seal::BatchEncoder> batch_encoder_;
+};
+
+/**
+ * @brief Provides the cache of evaluation contexts shared by calculation threads.
+ *        The least recently used contexts are evicted when the number of
+ *        contexts or the total key size exceeds the limits.
+ */
+class KeyCache
+{
+public:
+    /**
+     * Constructor
+     * @param[in] dec_pool    connection pool to decryptor
+     * @param[in] max_entries max number of contexts to hold
+     * @param[in] max_bytes   max total size of keys to hold (bytes)
+     */
+    KeyCache(DecClientPool& dec_pool,
+             const size_t max_entries,
+             const size_t max_bytes);
+    virtual ~KeyCache() = default;
+
+    /**
+     * Get evaluation context. Keys are downloaded from decryptor if not cached.
+     * The key ID is checked on decryptor every time, and the cached context
+     * is discarded if the keys have been deleted.
+     * @param[in] key_id key ID
+     * @return evaluation context
+     */
+    std::shared_ptr<const KeyContext> get(const int32_t key_id);
+
+    /**
+     * Discard evaluation context
+     * @param[in] key_id key ID
+     */
+    void erase(const int32_t key_id);
+
+    /**
+     * Get number of cached contexts
+     * @return number of contexts
+     */
+    size_t size() const;
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> pimpl_;
+};
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_KEYCACHE_HPP */
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_cs/fts_cs_lutgeometry.hpp>
+
+namespace fts_cs
+{
+
+LUTGeometry calcLUTGeometryForOneInput(const int64_t input_num,
+                                       const int64_t row_size,
+                                       const int64_t rows)
+{
+    STDSC_THROW_INVPARAM_IF_CHECK(rows == 1 || rows == 2,
+                                  "num of packed rows must be 1 or 2");
+    const int64_t width = row_size * rows;
+    LUTGeometry geo;
+    geo.l  = row_size;
+    geo.k  = std::max<int64_t>(1, (input_num + width - 1) / width);
+    geo.ks = 0;
+    geo.rows = rows;
+    geo.possible_input_num = geo.k * width;
+    geo.possible_combination_num = 0;
+    return geo;
+}
+
+LUTGeometry calcLUTGeometryForTwoInput(const int64_t input_num_x,
+                                       const int64_t input_num_y,
+                                       const int64_t row_size)
+{
+    STDSC_THROW_INVPARAM_IF_CHECK(input_num_x <= row_size && input_num_y <= row_size,
+                                  "size of LUT of two input exceeds row size of plaintext matrix");
+    LUTGeometry geo;
+    geo.l  = row_size;
+    geo.k  = 1;
+    geo.ks = std::max<int64_t>(1, input_num_x);
+    geo.rows = 1;
+    geo.possible_input_num = row_size;
+    geo.possible_combination_num = geo.ks * row_size;
+    return geo;
+}
+
+} /* namespace fts_cs */
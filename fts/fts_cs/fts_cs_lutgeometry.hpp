@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_LUTGEOMETRY_HPP
+#define FTS_CS_LUTGEOMETRY_HPP
+
+#include <cstdint>
+
+namespace fts_cs
+{
+
+/**
+ * @brief Shape of the padded LUT for the plaintext matrix of a query.
+ */
+struct LUTGeometry
+{
+    int64_t l;  // row size of plaintext matrix
+    int64_t k;  // num of rows of input table
+    int64_t ks; // num of rows of output table (two input only)
+    int64_t rows; // num of batching rows packed per ciphertext (1 or 2)
+    int64_t possible_input_num;       // num of inputs after padding
+    int64_t possible_combination_num; // num of combinations after padding (two input only)
+};
+
+/**
+ * Calculate the geometry of LUT for one input.
+ * The table is padded to the next row boundary. When 'rows' is 2,
+ * each ciphertext carries two table rows, one in each batching row.
+ * @param[in] input_num num of inputs of LUT
+ * @param[in] row_size  row size of plaintext matrix
+ * @param[in] rows      num of batching rows packed per ciphertext (1 or 2)
+ * @return geometry
+ */
+LUTGeometry calcLUTGeometryForOneInput(const int64_t input_num,
+                                       const int64_t row_size,
+                                       const int64_t rows = 1);
+
+/**
+ * Calculate the geometry of LUT for two input.
+ * Each input table is padded to one row. The real x inputs are placed
+ * in front of the permuted table, so that the output table needs only
+ * 'input_num_x' rows.
+ * @param[in] input_num_x num of inputs x of LUT
+ * @param[in] input_num_y num of inputs y of LUT
+ * @param[in] row_size    row size of plaintext matrix
+ * @return geometry
+ */
+LUTGeometry calcLUTGeometryForTwoInput(const int64_t input_num_x,
+                                       const int64_t input_num_y,
+                                       const int64_t row_size);
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_LUTGEOMETRY_HPP */
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_METRICS_HPP
+#define FTS_CS_METRICS_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace fts_cs
+{
+
+/**
+ * @brief This class is used to hold the counters of calculation.
+ */
+struct CalcMetrics
+{
+    std::atomic<uint64_t> cancelled_queries {0}; // queries dropped by cancel request
+    std::atomic<uint64_t> expired_queries   {0}; // queries dropped by deadline
+    std::atomic<uint64_t> dropped_rows      {0}; // rows of computationA/B skipped by the above
+    std::atomic<uint64_t> rejected_queries  {0}; // queries rejected by overload
+    std::atomic<uint64_t> expired_results   {0}; // results deleted by lifetime
+    std::atomic<uint64_t> evicted_results   {0}; // results deleted by memory cap
+    std::atomic<uint64_t> result_bytes      {0}; // size of results held, as of the last reap
+};
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_METRICS_HPP */
@@ -22,19 +22,28 @@
 namespace fts_cs
 {
 Query::Query(const int32_t key_id, const fts_share::FuncNo_t func_no,
-             const std::vector<seal::Ciphertext>& ctxts)
+             const std::vector<seal::Ciphertext>& ctxts,
+             const uint32_t deadline_msec)
     : key_id_(key_id),
-      func_no_(func_no)
+      func_no_(func_no),
+      deadline_msec_(deadline_msec)
 {
     ctxts_.resize(ctxts.size());
     std::copy(ctxts.begin(), ctxts.end(), ctxts_.begin());
 }
 
-int32_t QueryQueue::push(const Query& data)
+int32_t QueryQueue::push(const Query& data, const double cost)
 {
-    auto id = fts_share::utility::gen_uuid();
-    super::push(id, data);
-    return id;
+    SchedEntry entry;
+    entry.query_id = fts_share::utility::gen_uuid();
+    entry.key_id   = data.key_id_;
+    entry.cost     = cost;
+    if (data.deadline_msec_ > 0) {
+        entry.deadline = entry.submit_time + std::chrono::milliseconds(data.deadline_msec_);
+        entry.has_deadline = true;
+    }
+    super::push(entry, data);
+    return entry.query_id;
 }
 
 } /* namespace fts_cs */
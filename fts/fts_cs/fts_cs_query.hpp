@@ -18,10 +18,12 @@
 #ifndef FTS_CS_QUERY_HPP
 #define FTS_CS_QUERY_HPP
 
+#include <atomic>
+#include <memory>
 #include <cstdint>
 #include <vector>
-#include <fts_share/fts_concurrent_mapqueue.hpp>
 #include <fts_share/fts_funcno.hpp>
+#include <fts_cs/fts_cs_scheduler.hpp>
 
 #include <seal/seal.h>
 
@@ -39,9 +41,11 @@ struct Query
      * @param[in] key_id key ID
      * @param[in] func_no function NO
      * @param[in] ctxts cipher texts
+     * @param[in] deadline_msec deadline from submission (msec, 0: none)
      */
     Query(const int32_t key_id, const fts_share::FuncNo_t func_no,
-          const std::vector<seal::Ciphertext>& ctxts);
+          const std::vector<seal::Ciphertext>& ctxts,
+          const uint32_t deadline_msec = 0);
     virtual ~Query() = default;
 
     /**
@@ -52,30 +56,41 @@ struct Query
     {
         key_id_ = q.key_id_;
         func_no_ = q.func_no_;
+        deadline_msec_ = q.deadline_msec_;
+        cancelled_ = q.cancelled_;
+        admission_ = q.admission_;
         ctxts_.resize(q.ctxts_.size());
         std::copy(q.ctxts_.begin(), q.ctxts_.end(), ctxts_.begin());
     }
 
     int32_t key_id_;
     fts_share::FuncNo_t func_no_;
+    uint32_t deadline_msec_ = 0;
+    std::shared_ptr<std::atomic<bool>> cancelled_  // set by cancel request,
+        = std::make_shared<std::atomic<bool>>(false); // shared by copies
+    std::shared_ptr<void> admission_; // reservation of admission control, released with the last copy
     std::vector<seal::Ciphertext> ctxts_;
 };
 
 /**
  * @brief This class is used to hold the queue of queries.
  */
-struct QueryQueue : public fts_share::ConcurrentMapQueue<int32_t, fts_cs::Query>
+struct QueryQueue : public ScheduledQueue<fts_cs::Query>
 {
-    using super = fts_share::ConcurrentMapQueue<int32_t, fts_cs::Query>;
+    using super = ScheduledQueue<fts_cs::Query>;
     
-    QueryQueue() = default;
+    explicit QueryQueue(const SchedPolicy_t policy = kSchedPolicyFIFO)
+        : super(policy)
+    {}
     virtual ~QueryQueue() = default;
 
     /**
      * Push query in queue
      * @param[in] data query
+     * @param[in] cost estimated work of query
+     * @return query ID
      */
-    virtual int32_t push(const Query& data);
+    virtual int32_t push(const Query& data, const double cost);
 };
 
 } /* namespace fts_cs */
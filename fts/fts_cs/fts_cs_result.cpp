@@ -15,6 +15,7 @@
  * limitations under the License.
  */
 
+#include <stdsc/stdsc_log.hpp>
 #include <fts_cs/fts_cs_result.hpp>
 #include <seal/seal.h>
 
@@ -35,5 +36,104 @@ double Result::elapsed_time() const
     auto now = std::chrono::system_clock::now();
     return std::chrono::duration_cast<std::chrono::seconds>(now - created_time_).count();
 }
+
+size_t Result::bytes() const
+{
+    return sizeof(Result) + ctxt_.uint64_count() * sizeof(uint64_t);
+}
+
+// ResultQueue
+void ResultQueue::push(const int32_t& key, const Result& val)
+{
+    // Counted before push, because the result may be popped at once.
+    const auto sz = val.bytes();
+    bytes_ += sz;
+    try {
+        super::push(key, val);
+    } catch (...) {
+        bytes_ -= sz;
+        throw;
+    }
+    
+    std::lock_guard<std::mutex> lock(heap_mtx_);
+    heap_.emplace(val.created_time_, key);
+}
+
+size_t ResultQueue::bytes() const
+{
+    return bytes_.load();
+}
+
+bool ResultQueue::next_expiry(const double lifetime_sec, TimePoint& expiry) const
+{
+    std::lock_guard<std::mutex> lock(heap_mtx_);
+    if (heap_.empty()) {
+        return false;
+    }
+    expiry = heap_.top().first
+        + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::duration<double>(lifetime_sec));
+    return true;
+}
+
+void ResultQueue::reap(const double lifetime_sec, const size_t max_bytes,
+                       size_t& num_expired, size_t& num_evicted)
+{
+    num_expired = num_evicted = 0;
+    const auto now = std::chrono::system_clock::now();
+    const auto lifetime = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::duration<double>(lifetime_sec));
+
+    while (true) {
+        Entry entry;
+        {
+            std::lock_guard<std::mutex> lock(heap_mtx_);
+            if (heap_.empty()) {
+                break;
+            }
+            entry = heap_.top();
+            const bool expired = now - entry.first >= lifetime;
+            if (!expired && bytes() <= max_bytes) {
+                break;
+            }
+            heap_.pop();
+        }
+
+        // The heap lock is released before the queue is locked.
+        Result tmp;
+        if (!pop(entry.second, tmp)) {
+            continue; // already popped
+        }
+        if (now - entry.first >= lifetime) {
+            STDSC_LOG_INFO("Deleted the results of query#%d because it has expired.", entry.second);
+            ++num_expired;
+        } else {
+            STDSC_LOG_INFO("Deleted the results of query#%d because results exceed %lu bytes.",
+                           entry.second, max_bytes);
+            ++num_evicted;
+        }
+    }
+
+    // Drop the entries of popped results if they have piled up.
+    std::lock_guard<std::mutex> lock(heap_mtx_);
+    if (heap_.size() > 2 * size() + 64) {
+        std::vector<Entry> entries;
+        entries.reserve(size());
+        while (!heap_.empty()) {
+            if (count(heap_.top().second)) {
+                entries.push_back(heap_.top());
+            }
+            heap_.pop();
+        }
+        for (const auto& entry : entries) {
+            heap_.push(entry);
+        }
+    }
+}
+
+void ResultQueue::on_erase(const int32_t& key, const Result& val)
+{
+    bytes_ -= val.bytes();
+}
     
 } /* namespace fts_cs */
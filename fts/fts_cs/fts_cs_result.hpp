@@ -21,6 +21,10 @@
 #include <cstdint>
 #include <cstdbool>
 #include <chrono>
+#include <mutex>
+#include <atomic>
+#include <queue>
+#include <vector>
 #include <fts_share/fts_concurrent_mapqueue.hpp>
 #include <seal/seal.h>
 
@@ -44,6 +48,12 @@ struct Result
 
     double elapsed_time() const;
 
+    /**
+     * Get memory size of result
+     * @return size (bytes)
+     */
+    size_t bytes() const;
+
     int32_t query_id_;
     bool status_;
     seal::Ciphertext ctxt_;
@@ -52,13 +62,57 @@ struct Result
 
 /**
  * @brief This class is used to hold the queue of results.
+ *
+ * The queue keeps the total size of results, and the min-heap of results
+ * ordered by created time so that expired or oldest results are found
+ * without scanning the queue. The heap entries of results which have been
+ * popped are left in the heap and skipped when they come to the top.
  */
 struct ResultQueue : public fts_share::ConcurrentMapQueue<int32_t, Result>
 {
     using super = fts_share::ConcurrentMapQueue<int32_t, Result>;
+    using TimePoint = std::chrono::system_clock::time_point;
     
-    ResultQueue() = default;
+    ResultQueue() : bytes_(0) {}
     virtual ~ResultQueue() = default;
+
+    virtual void push(const int32_t& key, const Result& val) override;
+
+    /**
+     * Get total size of results
+     * @return size (bytes)
+     */
+    size_t bytes() const;
+
+    /**
+     * Get the time when the oldest result expires
+     * @param[in] lifetime_sec lifetime of results (sec)
+     * @param[out] expiry time
+     * @return false if no results
+     */
+    bool next_expiry(const double lifetime_sec, TimePoint& expiry) const;
+
+    /**
+     * Delete results which have expired lifetime, then delete the oldest
+     * results until total size of results is within max_bytes.
+     * @param[in] lifetime_sec lifetime of results (sec)
+     * @param[in] max_bytes max total size of results (bytes)
+     * @param[out] num_expired num of results deleted by lifetime
+     * @param[out] num_evicted num of results deleted by max_bytes
+     */
+    void reap(const double lifetime_sec, const size_t max_bytes,
+              size_t& num_expired, size_t& num_evicted);
+
+protected:
+    virtual void on_erase(const int32_t& key, const Result& val) override;
+
+private:
+    using Entry = std::pair<TimePoint, int32_t>;
+    
+    std::atomic<size_t> bytes_;
+    // Locked without the locks of the queue held.
+    mutable std::mutex heap_mtx_;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap_;
 };
 
 } /* namespace fts_cs */
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+#include <stdsc/stdsc_log.hpp>
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_cs/fts_cs_result.hpp>
+#include <fts_cs/fts_cs_metrics.hpp>
+#include <fts_cs/fts_cs_result_reaper.hpp>
+
+namespace fts_cs
+{
+
+struct ResultReaper::Impl
+{
+    Impl(ResultQueue& rque,
+         CalcMetrics& metrics,
+         const double lifetime_sec,
+         const size_t max_bytes)
+        : rque_(rque),
+          metrics_(metrics),
+          lifetime_sec_(lifetime_sec),
+          max_bytes_(max_bytes)
+    {
+    }
+
+    void exec(ResultReaperParam& args, std::shared_ptr<stdsc::ThreadException> te)
+    {
+        STDSC_LOG_INFO("Launched result reaper thread. (lifetime: %.0f sec, max bytes: %lu)",
+                       lifetime_sec_, max_bytes_);
+
+        while (!args.force_finish) {
+            reap();
+
+            // Wake up when the oldest result expires.
+            auto wakeup = std::chrono::system_clock::now()
+                + std::chrono::milliseconds(args.retry_interval_msec);
+            ResultQueue::TimePoint expiry;
+            if (rque_.next_expiry(lifetime_sec_, expiry)) {
+                wakeup = std::min(wakeup, expiry);
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!args.force_finish) {
+                cond_.wait_until(lock, wakeup);
+            }
+        }
+    }
+
+    void reap()
+    {
+        size_t num_expired, num_evicted;
+        rque_.reap(lifetime_sec_, max_bytes_, num_expired, num_evicted);
+        metrics_.expired_results += num_expired;
+        metrics_.evicted_results += num_evicted;
+        metrics_.result_bytes = rque_.bytes();
+    }
+
+    ResultQueue& rque_;
+    CalcMetrics& metrics_;
+    const double lifetime_sec_;
+    const size_t max_bytes_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    ResultReaperParam param_;
+    std::shared_ptr<stdsc::ThreadException> te_;
+};
+
+ResultReaper::ResultReaper(ResultQueue& rque,
+                           CalcMetrics& metrics,
+                           const double lifetime_sec,
+                           const size_t max_bytes)
+    : pimpl_(new Impl(rque, metrics, lifetime_sec, max_bytes))
+{}
+
+void ResultReaper::start()
+{
+    pimpl_->param_.force_finish = false;
+    super::start(pimpl_->param_, pimpl_->te_);
+}
+
+void ResultReaper::stop()
+{
+    STDSC_LOG_INFO("Stop result reaper thread.");
+    {
+        std::lock_guard<std::mutex> lock(pimpl_->mutex_);
+        pimpl_->param_.force_finish = true;
+    }
+    pimpl_->cond_.notify_all();
+}
+
+void ResultReaper::reap()
+{
+    pimpl_->reap();
+}
+
+void ResultReaper::exec(ResultReaperParam& args, std::shared_ptr<stdsc::ThreadException> te) const
+{
+    pimpl_->exec(args, te);
+}
+
+} /* namespace fts_cs */
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_RESULT_REAPER_HPP
+#define FTS_CS_RESULT_REAPER_HPP
+
+#include <memory>
+#include <cstdbool>
+#include <stdsc/stdsc_thread.hpp>
+#include <fts_share/fts_define.hpp>
+
+namespace fts_cs
+{
+
+class ResultReaperParam;
+struct ResultQueue;
+struct CalcMetrics;
+
+/**
+ * @brief Provides the thread to delete results which have expired lifetime
+ *        or exceed the memory cap. The thread sleeps until the oldest result
+ *        expires, and at most 'retry_interval_msec' to keep the memory cap.
+ */
+class ResultReaper : public stdsc::Thread<ResultReaperParam>
+{
+    using super = Thread<ResultReaperParam>;
+public:
+    /**
+     * Constructor
+     * @param[in,out] rque result queue
+     * @param[in,out] metrics counters of calculation
+     * @param[in] lifetime_sec lifetime of results (sec)
+     * @param[in] max_bytes max total size of results (bytes)
+     */
+    ResultReaper(ResultQueue& rque,
+                 CalcMetrics& metrics,
+                 const double lifetime_sec,
+                 const size_t max_bytes = FTS_DEFAULT_MAX_RESULT_BYTES);
+    virtual ~ResultReaper(void) = default;
+
+    /**
+     * Start thread
+     */
+    void start();
+
+    /**
+     * Stop thread
+     */
+    void stop();
+
+    /**
+     * Delete results now
+     */
+    void reap();
+
+private:
+    virtual void exec(ResultReaperParam& args,
+                      std::shared_ptr<stdsc::ThreadException> te) const override;
+
+    struct Impl;
+    std::shared_ptr<Impl> pimpl_;
+};
+
+/**
+ * @brief This class is used to hold the parameters for ResultReaper.
+ */
+struct ResultReaperParam
+{
+    uint32_t retry_interval_msec = DefaultRetryIntervalMsec;
+    bool force_finish = false;
+
+    static constexpr uint32_t DefaultRetryIntervalMsec = FTS_RESULT_REAP_INTERVAL_MSEC;
+};
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_RESULT_REAPER_HPP */
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_share/fts_taskpool.hpp>
+#include <fts_cs/fts_cs_rotation.hpp>
+
+namespace fts_cs
+{
+
+RotationEngine::RotationEngine(seal::Evaluator& evaluator,
+                               const seal::GaloisKeys& galoiskey)
+    : evaluator_(evaluator),
+      galoiskey_(galoiskey)
+{}
+
+void RotationEngine::rotate_rows_series(const seal::Ciphertext& src,
+                                        const int64_t begin,
+                                        const int64_t end,
+                                        std::vector<seal::Ciphertext>& dst) const
+{
+    STDSC_THROW_INVPARAM_IF_CHECK(begin < end, "invalid range of rotation steps");
+    
+    const int64_t n = end - begin;
+    dst.resize(n);
+
+    // Rotated by the binary digits of begin, since the keys of positive
+    // steps, which SEAL uses to compose other steps, are not generated.
+    dst[0] = src;
+    for (int64_t h=1; h<=begin; h*=2) {
+        if (begin & h) {
+            evaluator_.rotate_rows_inplace(dst[0], -h, galoiskey_);
+        }
+    }
+
+    // dst[j] (h <= j < 2h) is dst[j-h] rotated by -h,
+    // where h is a power of two and has its own galois key.
+    for (int64_t h=1; h<n; h*=2) {
+        const int64_t lim = std::min<int64_t>(2 * h, n);
+        fts_share::TaskPool::shared().parallel_for(h, lim, [&](int64_t j) {
+            dst[j] = dst[j - h];
+            evaluator_.rotate_rows_inplace(dst[j], -h, galoiskey_);
+        });
+    }
+}
+
+} /* namespace fts_cs */
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_ROTATION_HPP
+#define FTS_CS_ROTATION_HPP
+
+#include <vector>
+#include <seal/seal.h>
+
+namespace fts_cs
+{
+
+/**
+ * @brief Provides rotations of one ciphertext by a series of steps.
+ *
+ * Rotating by -i directly costs as many key switchings as the number of
+ * power-of-two galois keys composing i. This class derives each rotation
+ * from an already rotated ciphertext by one power-of-two step instead,
+ * so every rotation after the first one costs exactly one key switching.
+ * Only the galois keys of steps -h (h: power of two) are required,
+ * which are given by fts_share::seal_utility::rotation_steps.
+ */
+class RotationEngine
+{
+public:
+    /**
+     * Constructor
+     * @param[in] evaluator evaluator
+     * @param[in] galoiskey galois keys
+     */
+    RotationEngine(seal::Evaluator& evaluator,
+                   const seal::GaloisKeys& galoiskey);
+    virtual ~RotationEngine() = default;
+
+    /**
+     * Rotate rows of ciphertext by steps -begin, -(begin+1), ..., -(end-1)
+     * @param[in] src   source ciphertext
+     * @param[in] begin first step (negated)
+     * @param[in] end   last step (negated, exclusive)
+     * @param[out] dst  rotated ciphertexts (dst[i] is rotated by -(begin+i))
+     */
+    void rotate_rows_series(const seal::Ciphertext& src,
+                            const int64_t begin,
+                            const int64_t end,
+                            std::vector<seal::Ciphertext>& dst) const;
+
+private:
+    seal::Evaluator& evaluator_;
+    const seal::GaloisKeys& galoiskey_;
+};
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_ROTATION_HPP */
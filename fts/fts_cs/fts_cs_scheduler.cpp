@@ -0,0 +1,242 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <set>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <fts_cs/fts_cs_scheduler.hpp>
+
+#define SCHED_COST_AGING_SEC (10.0) // waiting time which halves the cost of a query
+
+namespace fts_cs
+{
+
+/**
+ * @brief Takes entries in order of arrival.
+ */
+class FIFOScheduler : public Scheduler
+{
+public:
+    virtual void push(const SchedEntry& entry) override
+    {
+        entries_.push_back(entry);
+    }
+
+    virtual bool pop(SchedEntry& entry) override
+    {
+        if (entries_.empty()) {
+            return false;
+        }
+        entry = entries_.front();
+        entries_.pop_front();
+        return true;
+    }
+
+    virtual size_t size(void) const override
+    {
+        return entries_.size();
+    }
+
+private:
+    std::deque<SchedEntry> entries_;
+};
+
+/**
+ * @brief Start-time fair queuing among key IDs. Each key ID is a flow and
+ *        each query consumes its estimated cost, so that a burst of costly
+ *        queries of one key ID does not delay the queries of the others.
+ */
+class FairScheduler : public Scheduler
+{
+public:
+    virtual void push(const SchedEntry& entry) override
+    {
+        Tagged t;
+        t.entry  = entry;
+        t.start  = std::max(vtime_, last_finish_[entry.key_id]);
+        t.finish = t.start + entry.cost;
+        last_finish_[entry.key_id] = t.finish;
+        flows_[entry.key_id].push_back(t);
+        ++size_;
+    }
+
+    virtual bool pop(SchedEntry& entry) override
+    {
+        if (flows_.empty()) {
+            return false;
+        }
+
+        auto best = flows_.begin();
+        for (auto it = flows_.begin(); it != flows_.end(); ++it) {
+            if (it->second.front().start < best->second.front().start) {
+                best = it;
+            }
+        }
+
+        const auto& t = best->second.front();
+        entry  = t.entry;
+        vtime_ = t.start;
+        best->second.pop_front();
+        --size_;
+
+        if (best->second.empty()) {
+            // The finish tag of an idle flow behind the virtual time has no effect.
+            const int32_t key_id = best->first;
+            flows_.erase(best);
+            if (last_finish_[key_id] <= vtime_) {
+                last_finish_.erase(key_id);
+            }
+        }
+        if (flows_.empty()) {
+            last_finish_.clear();
+        }
+        return true;
+    }
+
+    virtual size_t size(void) const override
+    {
+        return size_;
+    }
+
+private:
+    struct Tagged
+    {
+        SchedEntry entry;
+        double start;
+        double finish;
+    };
+
+    std::map<int32_t, std::deque<Tagged>> flows_;
+    std::map<int32_t, double> last_finish_;
+    double vtime_ = 0.0;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Takes the entry of the earliest deadline. Entries without
+ *        deadline are taken after them in order of arrival.
+ */
+class EDFScheduler : public Scheduler
+{
+public:
+    virtual void push(const SchedEntry& entry) override
+    {
+        entries_.insert(Node{entry, seq_++});
+    }
+
+    virtual bool pop(SchedEntry& entry) override
+    {
+        if (entries_.empty()) {
+            return false;
+        }
+        entry = entries_.begin()->entry;
+        entries_.erase(entries_.begin());
+        return true;
+    }
+
+    virtual size_t size(void) const override
+    {
+        return entries_.size();
+    }
+
+private:
+    struct Node
+    {
+        SchedEntry entry;
+        uint64_t seq;
+
+        bool operator<(const Node& rhs) const
+        {
+            if (entry.has_deadline != rhs.entry.has_deadline) {
+                return entry.has_deadline;
+            }
+            if (entry.has_deadline && entry.deadline != rhs.entry.deadline) {
+                return entry.deadline < rhs.entry.deadline;
+            }
+            return seq < rhs.seq;
+        }
+    };
+
+    std::set<Node> entries_;
+    uint64_t seq_ = 0;
+};
+
+/**
+ * @brief Takes the entry of the smallest estimated cost. The cost is
+ *        reduced by the waiting time, so that costly queries are not
+ *        starved by a stream of cheap ones.
+ */
+class CostScheduler : public Scheduler
+{
+public:
+    virtual void push(const SchedEntry& entry) override
+    {
+        entries_.push_back(entry);
+    }
+
+    virtual bool pop(SchedEntry& entry) override
+    {
+        if (entries_.empty()) {
+            return false;
+        }
+
+        const auto now = SchedEntry::Clock::now();
+        size_t best = 0;
+        double best_score = 0.0;
+        for (size_t i=0; i<entries_.size(); ++i) {
+            const double waited_sec = std::chrono::duration<double>(
+                now - entries_[i].submit_time).count();
+            const double score = entries_[i].cost / (1.0 + waited_sec / SCHED_COST_AGING_SEC);
+            if (i == 0 || score < best_score) {
+                best = i;
+                best_score = score;
+            }
+        }
+
+        entry = entries_[best];
+        entries_.erase(entries_.begin() + best);
+        return true;
+    }
+
+    virtual size_t size(void) const override
+    {
+        return entries_.size();
+    }
+
+private:
+    std::vector<SchedEntry> entries_;
+};
+
+std::unique_ptr<Scheduler> make_scheduler(const SchedPolicy_t policy)
+{
+    switch (policy) {
+        case kSchedPolicyFIFO:
+            return std::unique_ptr<Scheduler>(new FIFOScheduler());
+        case kSchedPolicyFair:
+            return std::unique_ptr<Scheduler>(new FairScheduler());
+        case kSchedPolicyEDF:
+            return std::unique_ptr<Scheduler>(new EDFScheduler());
+        case kSchedPolicyCost:
+            return std::unique_ptr<Scheduler>(new CostScheduler());
+        default:
+            STDSC_THROW_INVPARAM("Invalid scheduling policy.");
+    }
+}
+
+} /* namespace fts_cs */
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_CS_SCHEDULER_HPP
+#define FTS_CS_SCHEDULER_HPP
+
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_share/fts_concurrent_mapqueue.hpp>
+
+namespace fts_cs
+{
+
+/**
+ * @brief Enumeration for scheduling policy of queries.
+ */
+enum SchedPolicy_t : int32_t
+{
+    kSchedPolicyFIFO = 0, // in order of arrival
+    kSchedPolicyFair = 1, // fair queuing among key IDs weighted by estimated cost
+    kSchedPolicyEDF  = 2, // earliest deadline first, queries without deadline last
+    kSchedPolicyCost = 3, // smallest estimated cost first, aged by waiting time
+};
+
+/**
+ * Get name of scheduling policy
+ * @param[in] policy scheduling policy
+ * @return name
+ */
+inline const char* sched_policy_name(const SchedPolicy_t policy)
+{
+    switch (policy) {
+        case kSchedPolicyFIFO: return "fifo";
+        case kSchedPolicyFair: return "fair";
+        case kSchedPolicyEDF:  return "edf";
+        case kSchedPolicyCost: return "cost";
+        default:               return "unknown";
+    }
+}
+
+/**
+ * @brief This class is used to hold the attributes of a query used for scheduling.
+ */
+struct SchedEntry
+{
+    using Clock = std::chrono::steady_clock;
+
+    int32_t query_id = -1;
+    int32_t key_id   = -1;
+    double cost      = 1.0;  // estimated work of query (relative)
+    Clock::time_point submit_time = Clock::now();
+    Clock::time_point deadline;
+    bool has_deadline = false;
+};
+
+/**
+ * @brief Interface of scheduling policy. Decides the order in which
+ *        queries waiting for a stage are taken. Not thread-safe.
+ */
+class Scheduler
+{
+public:
+    virtual ~Scheduler(void) = default;
+
+    /**
+     * Add entry
+     * @param[in] entry entry
+     */
+    virtual void push(const SchedEntry& entry) = 0;
+
+    /**
+     * Take the next entry
+     * @param[out] entry entry
+     * @return false if no entry
+     */
+    virtual bool pop(SchedEntry& entry) = 0;
+
+    /**
+     * Get num of entries
+     * @return num of entries
+     */
+    virtual size_t size(void) const = 0;
+};
+
+/**
+ * Create scheduler
+ * @param[in] policy scheduling policy
+ * @return scheduler
+ */
+std::unique_ptr<Scheduler> make_scheduler(const SchedPolicy_t policy);
+
+/**
+ * @brief Queue of values keyed by query ID, taken in the order
+ *        decided by the scheduling policy.
+ *
+ * The values are held in the sharded queue, so that pushing and taking
+ * them does not contend. The order is decided over all of the queries,
+ * so the scheduler is guarded by a single lock, which is held only while
+ * an entry is added or picked. The value of an entry is pushed before
+ * the entry, so the value of a picked entry always exists.
+ */
+template <class Tv>
+class ScheduledQueue
+{
+public:
+    explicit ScheduledQueue(const SchedPolicy_t policy = kSchedPolicyFIFO)
+        : sched_(make_scheduler(policy))
+    {}
+    virtual ~ScheduledQueue(void) = default;
+
+    /**
+     * Change scheduling policy. Must be called while the queue is empty.
+     * @param[in] policy scheduling policy
+     */
+    void set_policy(const SchedPolicy_t policy)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        STDSC_THROW_INVPARAM_IF_CHECK(vals_.size() == 0, "queue is not empty");
+        sched_ = make_scheduler(policy);
+    }
+
+    /**
+     * Push value
+     * @param[in] entry scheduling attributes of query
+     * @param[in] val   value
+     */
+    virtual void push(const SchedEntry& entry, const Tv& val)
+    {
+        vals_.push(entry.query_id, val);
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            sched_->push(entry);
+        }
+        cond_.notify_one();
+    }
+
+    /**
+     * Pop the next value, waiting at most timeout
+     * @param[out] entry scheduling attributes of query
+     * @param[out] val   value
+     * @param[in] timeout_msec timeout (msec)
+     * @return false if timed out
+     */
+    virtual bool wait_pop(SchedEntry& entry, Tv& val, const uint32_t timeout_msec)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            if (!cond_.wait_for(lock, std::chrono::milliseconds(timeout_msec),
+                                [this]() { return sched_->size() > 0; })) {
+                return false;
+            }
+            sched_->pop(entry);
+        }
+        return vals_.pop(entry.query_id, val);
+    }
+
+    /**
+     * Get num of values
+     * @return num of values
+     */
+    size_t size(void) const
+    {
+        return vals_.size();
+    }
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    fts_share::ConcurrentMapQueue<int32_t, Tv> vals_;
+    std::unique_ptr<Scheduler> sched_;
+};
+
+} /* namespace fts_cs */
+
+#endif /* FTS_CS_SCHEDULER_HPP */
@@ -22,10 +22,25 @@ public:
          stdsc::StateContext& state,
          const uint32_t max_concurrent_queries,
          const uint32_t max_results,
-         const uint32_t result_lifetime_sec)
+         const uint32_t result_lifetime_sec,
+         const size_t max_cached_keys,
+         const size_t max_cached_key_bytes,
+         const size_t max_bundles,
+         const EvalMode_t eval_mode,
+         const size_t max_query_bytes,
+         const int64_t packed_rows,
+         const CalcStageThreads& stage_threads,
+         const SchedPolicy_t sched_policy,
+         const size_t max_result_bytes,
+         const size_t max_inflight_bytes,
+         const double max_inflight_cost)
         : dec_host_(dec_host),
           dec_port_(dec_port),
-          calc_manager_(new CalcManager(LUT_dir, max_concurrent_queries, max_results, result_lifetime_sec)),
+          stage_threads_(stage_threads),
+          calc_manager_(new CalcManager(LUT_dir, max_concurrent_queries, max_results, result_lifetime_sec,
+                                        max_cached_keys, max_cached_key_bytes, max_bundles,
+                                        eval_mode, max_query_bytes, packed_rows, sched_policy,
+                                        max_result_bytes, max_inflight_bytes, max_inflight_cost)),
           param_(new CallbackParam()),
           cparam_(new CommonCallbackParam(*calc_manager_))
     {
@@ -44,8 +59,7 @@ public:
         const bool enable_async_mode = true;
         server_->start(enable_async_mode);
 
-        const uint32_t thread_num = 2;
-        calc_manager_->start_threads(thread_num, dec_host_, dec_port_);
+        calc_manager_->start_threads(stage_threads_, dec_host_, dec_port_);
     }
 
     void stop(void)
@@ -62,6 +76,7 @@ public:
 private:
     std::string dec_host_;
     std::string dec_port_;
+    CalcStageThreads stage_threads_;
     std::shared_ptr<CalcManager> calc_manager_;
     std::shared_ptr<CallbackParam> param_;
     std::shared_ptr<CommonCallbackParam> cparam_;
@@ -76,12 +91,34 @@ CSServer::CSServer(const char* port,
                    stdsc::StateContext &state,
                    const uint32_t max_concurrent_queries,
                    const uint32_t max_results,
-                   const uint32_t result_lifetime_sec)
+                   const uint32_t result_lifetime_sec,
+                   const size_t max_cached_keys,
+                   const size_t max_cached_key_bytes,
+                   const size_t max_bundles,
+                   const EvalMode_t eval_mode,
+                   const size_t max_query_bytes,
+                   const int64_t packed_rows,
+                   const CalcStageThreads& stage_threads,
+                   const SchedPolicy_t sched_policy,
+                   const size_t max_result_bytes,
+                   const size_t max_inflight_bytes,
+                   const double max_inflight_cost)
     : pimpl_(new Impl(port, dec_host, dec_port,
                       LUT_dir, callback, state,
                       max_concurrent_queries,
                       max_results,
-                      result_lifetime_sec))
+                      result_lifetime_sec,
+                      max_cached_keys,
+                      max_cached_key_bytes,
+                      max_bundles,
+                      eval_mode,
+                      max_query_bytes,
+                      packed_rows,
+                      stage_threads,
+                      sched_policy,
+                      max_result_bytes,
+                      max_inflight_bytes,
+                      max_inflight_cost))
 {
 }
 
@@ -20,6 +20,9 @@
 
 #include <memory>
 #include <fts_share/fts_define.hpp>
+#include <fts_cs/fts_cs_evalmode.hpp>
+#include <fts_cs/fts_cs_calcstage.hpp>
+#include <fts_cs/fts_cs_scheduler.hpp>
 
 namespace fts_cs
 {
@@ -41,6 +44,17 @@ public:
      * @param[in] max_concurrent_queries max concurrent query number
      * @param[in] max_results            max result number
      * @param[in] result_lifetime_sec    result linefile (sec)
+     * @param[in] max_cached_keys        max number of keys to cache
+     * @param[in] max_cached_key_bytes   max total size of keys to cache (bytes)
+     * @param[in] max_bundles            max number of LUT bundles to prepare in background
+     * @param[in] eval_mode              evaluation mode of computationB
+     * @param[in] max_query_bytes        memory budget of computationB per query (bytes)
+     * @param[in] packed_rows            num of batching rows packed per ciphertext for one input (1 or 2)
+     * @param[in] stage_threads          num of calculation threads of each stage
+     * @param[in] sched_policy           scheduling policy of queries
+     * @param[in] max_result_bytes       max total size of results to hold (bytes)
+     * @param[in] max_inflight_bytes     max estimated memory of queries in flight (bytes)
+     * @param[in] max_inflight_cost      max estimated work of queries in flight
      */
     CSServer(const char* port,
              const char* dec_host,
@@ -50,7 +64,18 @@ public:
              stdsc::StateContext& state,
              const uint32_t max_concurrent_queries = FTS_DEFAULT_MAX_CONCURRENT_QUERIES,
              const uint32_t max_results = FTS_DEFAULT_MAX_RESULTS,
-             const uint32_t result_lifetime_sec = FTS_DEFAULT_MAX_RESULT_LIFETIME_SEC);
+             const uint32_t result_lifetime_sec = FTS_DEFAULT_MAX_RESULT_LIFETIME_SEC,
+             const size_t max_cached_keys = FTS_DEFAULT_MAX_CACHED_KEYS,
+             const size_t max_cached_key_bytes = FTS_DEFAULT_MAX_CACHED_KEY_BYTES,
+             const size_t max_bundles = FTS_DEFAULT_MAX_LUT_BUNDLES,
+             const EvalMode_t eval_mode = kEvalModeNTT,
+             const size_t max_query_bytes = FTS_DEFAULT_MAX_QUERY_BYTES,
+             const int64_t packed_rows = FTS_DEFAULT_PACKED_ROWS,
+             const CalcStageThreads& stage_threads = CalcStageThreads(),
+             const SchedPolicy_t sched_policy = kSchedPolicyFair,
+             const size_t max_result_bytes = FTS_DEFAULT_MAX_RESULT_BYTES,
+             const size_t max_inflight_bytes = FTS_DEFAULT_MAX_INFLIGHT_BYTES,
+             const double max_inflight_cost = FTS_DEFAULT_MAX_INFLIGHT_COST);
     ~CSServer(void) = default;
 
     /**
@@ -18,7 +18,9 @@
 #include <iostream>
 #include <cstring>
 #include <fstream>
-#include <omp.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <stdsc/stdsc_buffer.hpp>
 #include <stdsc/stdsc_state.hpp>
 #include <stdsc/stdsc_socket.hpp>
@@ -26,7 +28,7 @@
 #include <stdsc/stdsc_exception.hpp>
 #include <fts_share/fts_packet.hpp>
 #include <fts_share/fts_plaindata.hpp>
-#include <fts_share/fts_commonparam.hpp>
+#include <fts_share/fts_taskpool.hpp>
 #include <fts_share/fts_cs2decparam.hpp>
 #include <fts_share/fts_dec2csparam.hpp>
 #include <fts_share/fts_encdata.hpp>
@@ -64,9 +66,8 @@ DEFUN_DOWNLOAD(CallbackFunctionNewKeyRequest)
 
     plaindata.save_to_stream(stream);
 
-    seal::SecretKey seckey;
-    keycont.get(key_id, KeyKind_t::kKindSecKey, seckey);
-    seckey.save(stream);
+    auto seckey = keycont.wire_data(key_id, KeyKind_t::kKindSecKey);
+    stream.write(static_cast<const char*>(seckey->data()), seckey->size());
     
     STDSC_LOG_INFO("Sending new key request ack. (key ID: %d)", key_id);
     stdsc::Buffer* bsbuff = &buffstream;
@@ -86,18 +87,13 @@ DEFUN_UPDOWNLOAD(CallbackFunctionPubKeyRequest)
 
     auto key_id = *static_cast<const int32_t*>(buffer.data());
 
-    auto sz = keycont.data_size(key_id, KeyKind_t::kKindPubKey);
-    stdsc::BufferStream buffstream(sz);
-    std::iostream stream(&buffstream);
-
-    seal::PublicKey pubkey;
-    keycont.get(key_id, KeyKind_t::kKindPubKey, pubkey);
-    pubkey.save(stream);
+    // The serialized keys are sent as they are.
+    auto wire = keycont.wire_data(key_id, KeyKind_t::kKindPubKey);
+    auto sz = wire->size();
 
     STDSC_LOG_INFO("Sending public key request ack. (key ID: %d)", key_id);
-    stdsc::Buffer* bsbuff = &buffstream;
     sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataPubKey, sz));
-    sock.send_buffer(*bsbuff);
+    sock.send_buffer(*wire);
     state.set(kEventPubKeyRequest);
 }
 
@@ -112,18 +108,13 @@ DEFUN_UPDOWNLOAD(CallbackFunctionGaloisKeyRequest)
 
     auto key_id = *static_cast<const int32_t*>(buffer.data());
 
-    auto sz = keycont.data_size(key_id, KeyKind_t::kKindGaloisKey);
-    stdsc::BufferStream buffstream(sz);
-    std::iostream stream(&buffstream);
-
-    seal::GaloisKeys galoiskey;
-    keycont.get(key_id, KeyKind_t::kKindGaloisKey, galoiskey);
-    galoiskey.save(stream);
+    // The serialized keys are sent as they are.
+    auto wire = keycont.wire_data(key_id, KeyKind_t::kKindGaloisKey);
+    auto sz = wire->size();
 
     STDSC_LOG_INFO("Sending galois keys request ack. (key ID: %d)", key_id);
-    stdsc::Buffer* bsbuff = &buffstream;
     sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataGaloisKey, sz));
-    sock.send_buffer(*bsbuff);
+    sock.send_buffer(*wire);
     state.set(kEventGaloisKeyRequest);
 }
 
@@ -138,18 +129,13 @@ DEFUN_UPDOWNLOAD(CallbackFunctionRelinKeyRequest)
 
     auto key_id = *static_cast<const int32_t*>(buffer.data());
 
-    auto sz = keycont.data_size(key_id, KeyKind_t::kKindRelinKey);
-    stdsc::BufferStream buffstream(sz);
-    std::iostream stream(&buffstream);
-
-    seal::RelinKeys relinkey;
-    keycont.get(key_id, KeyKind_t::kKindRelinKey, relinkey);
-    relinkey.save(stream);
+    // The serialized keys are sent as they are.
+    auto wire = keycont.wire_data(key_id, KeyKind_t::kKindRelinKey);
+    auto sz = wire->size();
 
-    
-    stdsc::Buffer* bsbuff = &buffstream;
+    STDSC_LOG_INFO("Sending relin keys request ack. (key ID: %d)", key_id);
     sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataRelinKey, sz));
-    sock.send_buffer(*bsbuff);
+    sock.send_buffer(*wire);
     state.set(kEventRelinKeyRequest);
 }
 
@@ -164,18 +150,13 @@ DEFUN_UPDOWNLOAD(CallbackFunctionParamRequest)
 
     auto key_id = *static_cast<const int32_t*>(buffer.data());
 
-    auto sz = keycont.data_size(key_id, KeyKind_t::kKindParam);
-    stdsc::BufferStream buffstream(sz);
-    std::iostream stream(&buffstream);
-
-    seal::EncryptionParameters params(seal::scheme_type::BFV);
-    keycont.get_param(key_id, params);
-    seal::EncryptionParameters::Save(params, stream);
+    // The serialized parameters are sent as they are.
+    auto wire = keycont.wire_data(key_id, KeyKind_t::kKindParam);
+    auto sz = wire->size();
 
     STDSC_LOG_INFO("Sending encryption parameters ack. (key ID: %d)", key_id);
-    stdsc::Buffer* bsbuff = &buffstream;
     sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataParam, sz));
-    sock.send_buffer(*bsbuff);
+    sock.send_buffer(*wire);
     state.set(kEventParamRequest);
 }
 
@@ -194,6 +175,34 @@ DEFUN_DATA(CallbackFunctionDeleteKeyRequest)
     state.set(kEventDeleteKeysRequest);
 }
 
+// CallbackFunction for Key check Request
+DEFUN_UPDOWNLOAD(CallbackFunctionKeyCheckRequest)
+{
+    STDSC_LOG_TRACE("Received key check request. (current state : %s)",
+                    state.current_state_str().c_str());
+
+    DEF_CDATA_ON_ALL(fts_dec::CommonCallbackParam);
+    auto& keycont = cdata_a->keycont;
+
+    auto key_id = *static_cast<const int32_t*>(buffer.data());
+
+    stdsc::Buffer sbuffer(sizeof(int32_t));
+    *static_cast<int32_t*>(sbuffer.data()) = keycont.is_exist_key(key_id) ? 1 : 0;
+
+    sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataKeyCheck,
+                                             sbuffer.size()));
+    sock.send_buffer(sbuffer);
+    state.set(kEventKeyCheckRequest);
+}
+
+// CallbackFunction for Ping Request
+DEFUN_REQUEST(CallbackFunctionPingRequest)
+{
+    STDSC_LOG_TRACE("Received ping request. (current state : %s)",
+                    state.current_state_str().c_str());
+    state.set(kEventPingRequest);
+}
+
 static std::vector<int64_t> shift_work(const std::vector<int64_t>& query,
                                        const int64_t index,
                                        const int64_t num_slots)
@@ -213,12 +222,114 @@ static std::vector<int64_t> shift_work(const std::vector<int64_t>& query,
     return new_index;
 }
 
+/**
+ * Returns the offset of the first zero in the slots, or -1 if none.
+ * The slots are tested in blocks with a branch-free reduction so that
+ * the compiler can vectorize the loop, and only the block containing
+ * the zero is rescanned.
+ */
+static int64_t find_zero_slot(const int64_t* slots, const size_t num_slots)
+{
+    constexpr size_t kBlock = 8;
+    size_t i = 0;
+    for (; i + kBlock <= num_slots; i += kBlock) {
+        int64_t hit = 0;
+        for (size_t j=0; j<kBlock; ++j) {
+            hit |= (slots[i + j] == 0);
+        }
+        if (hit) {
+            break;
+        }
+    }
+    for (; i<num_slots; ++i) {
+        if (slots[i] == 0) {
+            return static_cast<int64_t>(i);
+        }
+    }
+    return -1;
+}
+
+/**
+ * Decrypts, decodes and scans the ciphertexts in parallel, and returns
+ * the position (ciphertext index * width + slot) of the first zero slot,
+ * or -1 if none. Once a zero is found, the ciphertexts after it are no
+ * longer decrypted.
+ * @param[in] ctxts   ciphertexts for each side
+ * @param[in] k       number of ciphertexts for each side
+ * @param[in] width   number of slots to scan in each ciphertext
+ * @param[in] decryptor decryptor
+ * @param[in] batch_encoder batch encoder
+ * @param[out] positions positions of the first zero for each side
+ */
+static void find_first_zeros(const std::vector<const std::vector<seal::Ciphertext>*>& ctxts,
+                             const int64_t k,
+                             const int64_t width,
+                             seal::Decryptor& decryptor,
+                             seal::BatchEncoder& batch_encoder,
+                             std::vector<int64_t>& positions)
+{
+    const int64_t num_sides = ctxts.size();
+    const int64_t none = std::numeric_limits<int64_t>::max();
+    std::vector<std::atomic<int64_t>> found(num_sides);
+    for (auto& f : found) {
+        f.store(none);
+    }
+
+    // The sides are interleaved so that every side advances together.
+    fts_share::TaskPool::shared().parallel_for(0, k * num_sides, [&](int64_t t) {
+        const int64_t side = t % num_sides;
+        const int64_t z = t / num_sides;
+        if (z * width >= found[side].load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        seal::Plaintext plain;
+        std::vector<int64_t> slots;
+        decryptor.decrypt((*ctxts[side])[z], plain);
+        batch_encoder.decode(plain, slots);
+
+        auto num_slots = std::min<size_t>(width, slots.size());
+        auto slot = find_zero_slot(slots.data(), num_slots);
+        if (slot < 0) {
+            return;
+        }
+
+        int64_t pos = z * width + slot;
+        int64_t cur = found[side].load(std::memory_order_relaxed);
+        while (pos < cur &&
+               !found[side].compare_exchange_weak(cur, pos, std::memory_order_relaxed)) {
+        }
+    });
+
+    positions.resize(num_sides);
+    for (int64_t s=0; s<num_sides; ++s) {
+        auto pos = found[s].load();
+        positions[s] = (pos == none) ? -1 : pos;
+    }
+}
+
+/**
+ * Encrypts the plaintext by adding it to a fresh encryption of zero,
+ * which is made in background. This is equivalent to encrypting it.
+ */
+static void encrypt_with_zero(KeyContainer& keycont,
+                              const int32_t key_id,
+                              seal::Evaluator& evaluator,
+                              const seal::Plaintext& plain,
+                              seal::Ciphertext& ctxt)
+{
+    keycont.encrypt_zero(key_id, ctxt);
+    evaluator.add_plain_inplace(ctxt, plain);
+}
+
 static fts_share::DecCalcResult_t
 calcPIRqueriesForOneInput(const std::vector<seal::Ciphertext>& midresults,
                           const seal::SecretKey& seckey,
-                          const seal::PublicKey& pubkey,
+                          KeyContainer& keycont,
+                          const int32_t key_id,
                           const seal::EncryptionParameters& params,
                           const int64_t possible_input_num_one,
+                          const int64_t packed_rows_one,
                           seal::Ciphertext& new_PIR_query,
                           seal::Ciphertext& new_PIR_index)
 {
@@ -226,7 +337,6 @@ calcPIRqueriesForOneInput(const std::vector<seal::Ciphertext>& midresults,
     
     auto context = seal::SEALContext::Create(params);
 
-    seal::Encryptor encryptor(context, pubkey);
     seal::Evaluator evaluator(context);
     seal::Decryptor decryptor(context, seckey);
 
@@ -236,57 +346,39 @@ calcPIRqueriesForOneInput(const std::vector<seal::Ciphertext>& midresults,
     std::cout << "  Plaintext matrix row size: " << row_size << std::endl;
     std::cout << "  Slot nums = " << slot_count << std::endl;
 
+    // Each ciphertext carries 'packed_rows' table rows, one in each batching row.
+    const int64_t packed_rows = std::max<int64_t>(1, std::min<int64_t>(2, packed_rows_one));
+    const int64_t width = row_size * packed_rows;
     int64_t l = row_size;
-    int64_t k = ceil(possible_input_num_one / row_size);
-
-    const auto& ct_result = midresults;
-    std::vector<std::vector<int64_t>> dec_result(k);
-    std::vector<seal::Plaintext> poly_dec_result;
-    for (int s=0; s<k; ++s) {
-        seal::Plaintext ex;
-        poly_dec_result.push_back(ex);
-    }
+    int64_t k = (possible_input_num_one + width - 1) / width;
 
     std::cout << "  Decrypting..."<< std::flush;
 
-    omp_set_num_threads(FTS_COMMONPARAM_NTHREADS);
-    #pragma omp parallel for
-    for (int z=0; z<k; ++z) {
-        decryptor.decrypt(ct_result[z], poly_dec_result[z]);
-        batch_encoder.decode(poly_dec_result[z], dec_result[z]);
-    }
+    std::vector<int64_t> positions;
+    find_first_zeros({&midresults}, k, width, decryptor, batch_encoder, positions);
 
     std::cout << "OK" << std::endl;
 
     std::cout << "  Making PIR-query..." << std::flush;
 
-    int64_t index;
-    std::vector<int64_t> new_query;
-    int64_t flag = 0;
-
-    for (int i=0; i<k; ++i) {
-        for (size_t j=0; j<row_size; ++j) {
-            if (dec_result[i][j] == 0 && flag == 0) {
-                index = i;
-                flag = 1;
-                for (size_t kk=0; kk<static_cast<size_t>(l); ++kk) {
-                    if (kk == j) {
-                        new_query.push_back(1);
-                    } else {
-                        new_query.push_back(0);
-                    }
-                }
-            }
-        }
-    }
-    if(flag == 0) {
+    if (positions[0] < 0) {
         std::cout << "ERROR: NO FIND INPUT NUMBER!" << std::endl;
         return fts_share::kDecCalcResultErrNoFoundInputMember;
     }
+
+    int64_t index = positions[0] / width;
+    std::vector<int64_t> new_query(width, 0);
+    new_query[positions[0] % width] = 1;
     std::cout << "OK" << std::endl;
 
+    // The row rotation on computation server shifts each batching row
+    // independently, so the index is shifted within each row.
     std::vector<int64_t> new_index;
-    new_index = shift_work(new_query, index, row_size);
+    for (int64_t r=0; r<packed_rows; ++r) {
+        std::vector<int64_t> row(new_query.begin() + r * l, new_query.begin() + (r + 1) * l);
+        auto shifted = shift_work(row, index, row_size);
+        new_index.insert(new_index.end(), shifted.begin(), shifted.end());
+    }
     std::cout << "  index is " << index << std::endl;
     new_query.resize(slot_count);
     new_index.resize(slot_count);
@@ -300,8 +392,8 @@ calcPIRqueriesForOneInput(const std::vector<seal::Ciphertext>& midresults,
     seal::Plaintext plaintext_new_PIR_index;
     batch_encoder.encode(new_index, plaintext_new_PIR_index);
 
-    encryptor.encrypt(plaintext_new_PIR_query, new_PIR_query);
-    encryptor.encrypt(plaintext_new_PIR_index, new_PIR_index);
+    encrypt_with_zero(keycont, key_id, evaluator, plaintext_new_PIR_query, new_PIR_query);
+    encrypt_with_zero(keycont, key_id, evaluator, plaintext_new_PIR_index, new_PIR_index);
 
     std::cout << "OK" << std::endl;
 
@@ -331,7 +423,8 @@ static fts_share::DecCalcResult_t
 calcPIRqueriesForTwoInput(const std::vector<seal::Ciphertext>& midresults_x,
                           const std::vector<seal::Ciphertext>& midresults_y,
                           const seal::SecretKey& seckey,
-                          const seal::PublicKey& pubkey,
+                          KeyContainer& keycont,
+                          const int32_t key_id,
                           const seal::EncryptionParameters& params,
                           const int64_t possible_input_num_two,
                           const int64_t possible_combination_num_two,
@@ -343,7 +436,6 @@ calcPIRqueriesForTwoInput(const std::vector<seal::Ciphertext>& midresults_x,
     
     auto context = seal::SEALContext::Create(params);
 
-    seal::Encryptor encryptor(context, pubkey);
     seal::Evaluator evaluator(context);
     seal::Decryptor decryptor(context, seckey);
 
@@ -354,86 +446,28 @@ calcPIRqueriesForTwoInput(const std::vector<seal::Ciphertext>& midresults_x,
     std::cout << "  Slot nums = " << slot_count << std::endl;
 
     int64_t l = row_size;
-    int64_t k = ceil(possible_input_num_two / row_size);
-
-    const auto& ct_result_x = midresults_x;
-    std::vector<std::vector<int64_t>> dec_result_x(k);
-    std::vector<seal::Plaintext> poly_dec_result_x;
-    for (int s=0; s<k; ++s) {
-        seal::Plaintext ex;
-        poly_dec_result_x.push_back(ex);
-    }
+    int64_t k = (possible_input_num_two + row_size - 1) / row_size;
 
-    const auto& ct_result_y = midresults_y;
-    std::vector<std::vector<int64_t>> dec_result_y(k);
-    std::vector<seal::Plaintext> poly_dec_result_y;
-    for (int s=0; s<k; ++s) {
-        seal::Plaintext ex;
-        poly_dec_result_y.push_back(ex);
-    }
-    
     std::cout << "  Decrypting..."<< std::flush;
 
-    omp_set_num_threads(FTS_COMMONPARAM_NTHREADS);
-    #pragma omp parallel for
-    for (int z=0; z<k; ++z) {
-        decryptor.decrypt(ct_result_x[z], poly_dec_result_x[z]);
-        batch_encoder.decode(poly_dec_result_x[z], dec_result_x[z]);
-    }
-    printf("caca\n");
-
-    omp_set_num_threads(FTS_COMMONPARAM_NTHREADS);
-    #pragma omp parallel for
-    for (int z=0; z<k; ++z) {
-        decryptor.decrypt(ct_result_y[z], poly_dec_result_y[z]);
-        batch_encoder.decode(poly_dec_result_y[z], dec_result_y[z]);
-    }
+    std::vector<int64_t> positions;
+    find_first_zeros({&midresults_x, &midresults_y}, k, l,
+                     decryptor, batch_encoder, positions);
 
     std::cout << "OK" << std::endl;
     
     std::cout << "  Making PIR-query..." << std::flush;
 
-    int64_t flag = 0;
-    int64_t index_row_x = -1, index_col_x = -1;
-    for (int64_t i=0; i<k; ++i) {
-        for(size_t j=0; j<row_size; ++j) {
-            if (dec_result_x[i][j] == 0 && flag == 0) {
-                index_row_x = i;
-                index_col_x = j;
-                flag = 1;
-            }
-        }
-    }
-
-    if(flag == 0) {
+    if (positions[0] < 0 || positions[1] < 0) {
         std::cout << "ERROR: NO FIND INPUT NUMBER!" << std::endl;
         return fts_share::kDecCalcResultErrNoFoundInputMember;
     }
 
-    flag = 0;
-    std::vector<int64_t> new_query0, new_query1, new_query2;
-    int64_t index_row_y = -1, index_col_y = -1;
-    for (int64_t i=0; i<k; ++i) {
-        for(size_t j=0; j<row_size; ++j) {
-            if (dec_result_y[i][j] == 0 && flag == 0) {
-                index_row_y = i;
-                index_col_y = j;
-                flag = 1;
-                for (size_t kk=0; kk<static_cast<size_t>(l); ++kk) {
-                    if(kk == j) {
-                        new_query0.push_back(1);
-                    } else {
-                        new_query0.push_back(0);
-                    }
-                }
-            }
-        }
-    }
+    int64_t index_row_x = positions[0] / l, index_col_x = positions[0] % l;
+    int64_t index_row_y = positions[1] / l, index_col_y = positions[1] % l;
 
-    if(flag == 0) {
-        std::cout << "ERROR: NO FIND INPUT NUMBER!" << std::endl;
-        return fts_share::kDecCalcResultErrNoFoundInputMember;
-    }
+    std::vector<int64_t> new_query0(l, 0), new_query1, new_query2;
+    new_query0[index_col_y] = 1;
 
     std:: cout << "index_row_x:" << index_row_x << ", index_col_x:" << index_col_x
                << ", index_row_y:" << index_row_y << ", index_col_y:" << index_col_y << std::endl;
@@ -458,11 +492,11 @@ calcPIRqueriesForTwoInput(const std::vector<seal::Ciphertext>& midresults_x,
 
     seal::Plaintext plaintext_new_PIR_query0, plaintext_new_PIR_query1, plaintext_new_PIR_query2;
     batch_encoder.encode(new_query0, plaintext_new_PIR_query0);
-    encryptor.encrypt(plaintext_new_PIR_query0, new_PIR_query0);
+    encrypt_with_zero(keycont, key_id, evaluator, plaintext_new_PIR_query0, new_PIR_query0);
     batch_encoder.encode(new_query1, plaintext_new_PIR_query1);
-    encryptor.encrypt(plaintext_new_PIR_query1, new_PIR_query1);
+    encrypt_with_zero(keycont, key_id, evaluator, plaintext_new_PIR_query1, new_PIR_query1);
     batch_encoder.encode(new_query2, plaintext_new_PIR_query2);
-    encryptor.encrypt(plaintext_new_PIR_query2, new_PIR_query2);
+    encrypt_with_zero(keycont, key_id, evaluator, plaintext_new_PIR_query2, new_PIR_query2);
     
     std::cout << "OK" << std::endl;
 
@@ -501,11 +535,27 @@ DEFUN_UPDOWNLOAD(CallbackFunctionCsMidResult)
     rplaindata.load_from_stream(rstream);
     const auto cs2decparam = rplaindata.data();
 
+    if (!keycont.is_exist_key(cs2decparam.key_id)) {
+        STDSC_LOG_WARN("Key #%d has been discarded.", cs2decparam.key_id);
+        fts_share::Dec2CsParam dec2csparam = {fts_share::kDecCalcResultErrNoFoundKeyID};
+        fts_share::PlainData<fts_share::Dec2CsParam> splaindata;
+        splaindata.push(dec2csparam);
+
+        auto sz = splaindata.stream_size();
+        stdsc::BufferStream sbuffstream(sz);
+        std::iostream sstream(&sbuffstream);
+        splaindata.save_to_stream(sstream);
+
+        stdsc::Buffer* bsbuff = &sbuffstream;
+        sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataCsMidResult, sz));
+        sock.send_buffer(*bsbuff);
+        state.set(kEventCsMidResult);
+        return;
+    }
+
     seal::SecretKey seckey;
-    seal::PublicKey pubkey;
     seal::EncryptionParameters params(seal::scheme_type::BFV);
     keycont.get(cs2decparam.key_id, KeyKind_t::kKindSecKey, seckey);
-    keycont.get(cs2decparam.key_id, KeyKind_t::kKindPubKey, pubkey);
     keycont.get_param(cs2decparam.key_id, params);
 
     fts_share::EncData enc_midresult_x(params), enc_midresult_y(params);
@@ -526,7 +576,7 @@ DEFUN_UPDOWNLOAD(CallbackFunctionCsMidResult)
     if (cs2decparam.func_no == fts_share::kFuncTwo) {
         res = calcPIRqueriesForTwoInput(enc_midresult_x.vdata(),
                                         enc_midresult_y.vdata(),
-                                        seckey, pubkey, params,
+                                        seckey, keycont, cs2decparam.key_id, params,
                                         cs2decparam.possible_input_num_two,
                                         cs2decparam.possible_combination_num_two,
                                         new_PIR_query[0],
@@ -534,8 +584,9 @@ DEFUN_UPDOWNLOAD(CallbackFunctionCsMidResult)
                                         new_PIR_query[2]);
     } else {
         res = calcPIRqueriesForOneInput(enc_midresult_x.vdata(),
-                                        seckey, pubkey, params,
+                                        seckey, keycont, cs2decparam.key_id, params,
                                         cs2decparam.possible_input_num_one,
+                                        cs2decparam.packed_rows_one,
                                         new_PIR_query[0], new_PIR_query[1]);
     }
 
@@ -552,7 +603,10 @@ DEFUN_UPDOWNLOAD(CallbackFunctionCsMidResult)
     splaindata.save_to_stream(sstream);
     enc_PIRquery.save_to_stream(sstream);
     
-    STDSC_LOG_INFO("Sending PIR queries.");
+    const auto& metrics = keycont.metrics();
+    STDSC_LOG_INFO("Sending PIR queries. (zero pool hits: %lu, misses: %lu, depth: %lu)",
+                   metrics.zero_pool_hits.load(), metrics.zero_pool_misses.load(),
+                   metrics.zero_pool_depth.load());
     stdsc::Buffer* bsbuff = &sbuffstream;
     sock.send_packet(stdsc::make_data_packet(fts_share::kControlCodeDataCsMidResult, sz));
     sock.send_buffer(*bsbuff);
@@ -53,10 +53,20 @@ DECLARE_UPDOWNLOAD_CLASS(CallbackFunctionParamRequest);
  */
 DECLARE_DATA_CLASS(CallbackFunctionDeleteKeyRequest);
 
+/**
+ * @brief Provides callback function in receiving key check request.
+ */
+DECLARE_UPDOWNLOAD_CLASS(CallbackFunctionKeyCheckRequest);
+
 /**
  * @brief Provides callback function in receiving mid-result.
  */
 DECLARE_UPDOWNLOAD_CLASS(CallbackFunctionCsMidResult);
+
+/**
+ * @brief Provides callback function in receiving ping request.
+ */
+DECLARE_REQUEST_CLASS(CallbackFunctionPingRequest);
     
 
 } /* namespace fts_dec */
@@ -25,4 +25,10 @@ CallbackParam::CallbackParam(void)
 {
 }
 
+CommonCallbackParam::CommonCallbackParam(const std::string& key_image_dir,
+                                         const size_t zero_pool_depth)
+    : keycont(key_image_dir, FTS_DEFAULT_KEY_POOL_SIZE, zero_pool_depth)
+{
+}
+
 } /* namespace fts_dec */
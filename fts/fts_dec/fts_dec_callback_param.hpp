@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <vector>
+#include <string>
 #include <fts_share/fts_user2decparam.hpp>
 #include <fts_dec/fts_dec_keycontainer.hpp>
 
@@ -42,6 +43,14 @@ struct CallbackParam
  */
 struct CommonCallbackParam
 {
+    /**
+     * Constructor
+     * @param[in] key_image_dir directory to save key images (empty: not saved)
+     * @param[in] zero_pool_depth num of encryptions of zero to hold for each key ID (0: no pool)
+     */
+    explicit CommonCallbackParam(const std::string& key_image_dir = "",
+                                 const size_t zero_pool_depth = FTS_DEFAULT_ZERO_POOL_DEPTH);
+    ~CommonCallbackParam(void) = default;
     KeyContainer keycont;
 };
 
@@ -1,9 +1,18 @@
+#include <array>
+#include <cstring>
+#include <cstdio>
 #include <fstream>
+#include <sstream>
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 #include <stdsc/stdsc_exception.hpp>
 #include <stdsc/stdsc_log.hpp>
+#include <stdsc/stdsc_buffer.hpp>
 #include <fts_share/fts_utility.hpp>
 #include <fts_share/fts_user2decparam.hpp>
+#include <fts_dec/fts_dec_keypool.hpp>
+#include <fts_dec/fts_dec_zeropool.hpp>
 #include <fts_dec/fts_dec_keycontainer.hpp>
 
 #include <seal/seal.h>
@@ -21,201 +30,270 @@
 namespace fts_dec
 {
 
-void print_parameters(std::shared_ptr<seal::SEALContext> context)
+/**
+ * @brief This class is used to hold the keys in memory. Each kind of keys is
+ * held in serialized form to send as it is, and the keys used by Decryptor
+ * are also held in deserialized form.
+ *
+ * If the image directory is set, the keys are also saved in the image file
+ * of each key ID, and the image files are read into memory at construction.
+ * The image file consists of the header, the size of each kind (uint64_t)
+ * and the serialized keys in order of kind.
+ *
+ * New keys are taken from the key pool, which generates keys in background.
+ * The encryptions of zero for PIR queries are taken from the zero pool,
+ * which encrypts them in background for each key ID.
+ */
+struct KeyContainer::Impl
 {
-    // Verify parameters
-    STDSC_THROW_INVPARAM_IF_CHECK(context, "context is not set");
-    auto &context_data = *context->context_data();
-
-    //Which scheme are we using?
-    std::string scheme_name;
-    switch (context_data.parms().scheme())
+    static constexpr const char* ImageMagic = "FTSKEYS1";
+    static constexpr const char* ImageExt   = "img";
+    
+    Impl(const std::string& image_dir, const size_t key_pool_size,
+         const size_t zero_pool_depth)
+        : image_dir_(image_dir)
     {
-    case seal::scheme_type::BFV:
-        scheme_name = "BFV";
-        break;
-    case seal::scheme_type::CKKS:
-        scheme_name = "CKKS";
-        break;
-    default:
-        STDSC_THROW_INVARIANT("unsupported scheme");
-    }
-
-    std::cout << "/ Encryption parameters:" << std::endl;
-    std::cout << "| scheme: " << scheme_name << std::endl;
-    std::cout << "| poly_modulus_degree: " <<
-        context_data.parms().poly_modulus_degree() << std::endl;
-
-    //Print the size of the true (product) coefficient modulus.
-    std::cout << "| coeff_modulus size: " << context_data.
-        total_coeff_modulus_bit_count() << " bits" << std::endl;
-
-    //For the BFV scheme print the plain_modulus parameter.
-    if (context_data.parms().scheme() == seal::scheme_type::BFV)  {
-        std::cout << "| plain_modulus: " << context_data.
-            parms().plain_modulus().value() << std::endl;
+        if (!image_dir_.empty()) {
+            load_images();
+        }
+        if (key_pool_size > 0) {
+            key_pool_ = std::make_shared<KeyPool>(key_pool_size);
+            key_pool_->start();
+        }
+        // The zero pool encrypts on the spot if the depth is 0.
+        zero_pool_ = std::make_shared<ZeroPool>(metrics_, zero_pool_depth);
+        if (zero_pool_depth > 0) {
+            zero_pool_->start();
+        }
     }
 
-    std::cout << "\\ noise_standard_deviation: " << context_data.
-        parms().noise_standard_deviation() << std::endl;
-    std::cout << std::endl;
-}
-    
-struct KeyContainer::Impl
-{
-    struct KeyFilenames
-    {    
-        KeyFilenames(const int32_t id)
-        {
-            filenames_.emplace(kKindPubKey,    std::string("pubkey_")    + std::to_string(id));
-            filenames_.emplace(kKindSecKey,    std::string("seckey_")    + std::to_string(id));
-            filenames_.emplace(kKindGaloisKey, std::string("galoiskey_") + std::to_string(id));
-            filenames_.emplace(kKindRelinKey,  std::string("relinkey_")  + std::to_string(id));
-            filenames_.emplace(kKindParam,     std::string("param_")     + std::to_string(id));
+    ~Impl()
+    {
+        if (key_pool_) {
+            key_pool_->stop();
         }
+        zero_pool_->stop();
+    }
 
-        std::string filename(const KeyKind_t kind) const
-        {
-            CHECK_KIND(kind);
-            return filenames_.at(kind);
+    void prepare_keys(const fts_share::User2DecParam& param)
+    {
+        if (key_pool_) {
+            key_pool_->reserve(param);
         }
-        
-        std::unordered_map<KeyKind_t, std::string> filenames_;
-    };
+    }
     
-    Impl()
-    {}
-
     int32_t new_keys(const fts_share::User2DecParam& param)
     {
-        int32_t key_id = fts_share::utility::gen_uuid();
-        map_.emplace(key_id, KeyFilenames(key_id));
-        generate_keyfiles(param.poly_mod_degree, param.coef_mod_192, param.plain_mod, map_.at(key_id));
+        auto keyset = key_pool_ ? key_pool_->pop(param) : generate_keyset(param);
+        
+        int32_t key_id;
+        do {
+            key_id = fts_share::utility::gen_uuid();
+        } while (is_exist_key(key_id));
+        // The image is written without the lock, since the keys are large.
+        if (!image_dir_.empty()) {
+            save_image(key_id, *keyset);
+        }
+        {
+            std::lock_guard<std::shared_timed_mutex> lock(mutex_);
+            map_.emplace(key_id, keyset);
+        }
+        zero_pool_->reserve(key_id, keyset);
         return key_id;
     }
     
     void delete_keys(const int32_t key_id)
     {
-        remove_keyfiles(map_.at(key_id));
+        std::lock_guard<std::shared_timed_mutex> lock(mutex_);
+        STDSC_THROW_INVPARAM_IF_CHECK(map_.count(key_id), "key ID is not found.");
         map_.erase(key_id);
+        zero_pool_->erase(key_id);
+        if (!image_dir_.empty()) {
+            const auto filename = image_filename(key_id);
+            if (!fts_share::utility::remove_file(filename)) {
+                std::ostringstream oss;
+                oss << "Failed to remove file. (" << filename << ")";
+                STDSC_THROW_FILE(oss.str());
+            }
+        }
+    }
+
+    bool is_exist_key(const int32_t key_id) const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+        return map_.count(key_id) > 0;
     }
 
     template <class T>
     void get(const int32_t key_id, const KeyKind_t kind, T& data) const
     {
-        const auto& filename = map_.at(key_id).filename(kind);
-        if (!fts_share::utility::file_exist(filename)) {
-            std::ostringstream oss;
-            oss << "File is not found. (" << filename << ")";
-            STDSC_THROW_FILE(oss.str());
-        }
-        std::ifstream ifs(filename);
-        data.unsafe_load(ifs);
+        auto wire = wire_data(key_id, kind);
+        MemoryStreamBuf buf(wire->data(), wire->size());
+        std::istream is(&buf);
+        data.unsafe_load(is);
+    }
 
-        ifs.close();
+    void get(const int32_t key_id, const KeyKind_t kind, seal::SecretKey& data) const
+    {
+        STDSC_THROW_INVPARAM_IF_CHECK(kind == kKindSecKey, "kind does not match secret key.");
+        data = find(key_id)->seckey;
+    }
+
+    void get(const int32_t key_id, const KeyKind_t kind, seal::PublicKey& data) const
+    {
+        STDSC_THROW_INVPARAM_IF_CHECK(kind == kKindPubKey, "kind does not match public key.");
+        data = find(key_id)->pubkey;
     }
 
     void get_param(const int32_t key_id, seal::EncryptionParameters& param) const
     {
-        const auto& filename = map_.at(key_id).filename(KeyKind_t::kKindParam);
-        if (!fts_share::utility::file_exist(filename)) {
-            std::ostringstream oss;
-            oss << "File is not found. (" << filename << ")";
-            STDSC_THROW_FILE(oss.str());
-        }
-        std::ifstream ifs(filename);
-        param = seal::EncryptionParameters::Load(ifs);
-        ifs.close();
+        param = find(key_id)->params;
+    }
+
+    std::shared_ptr<const stdsc::Buffer> wire_data(const int32_t key_id, const KeyKind_t kind) const
+    {
+        CHECK_KIND(kind);
+        return find(key_id)->wire[kind];
     }
 
     size_t data_size(const int32_t key_id, const KeyKind_t kind) const
     {
-        const auto& filename = map_.at(key_id).filename(kind);
-        if (!fts_share::utility::file_exist(filename)) {
-            std::ostringstream oss;
-            oss << "File is not found. (" << filename << ")";
-            STDSC_THROW_FILE(oss.str());
-        }
-        return fts_share::utility::file_size(filename);
+        return wire_data(key_id, kind)->size();
+    }
+
+    void encrypt_zero(const int32_t key_id, seal::Ciphertext& ctxt)
+    {
+        zero_pool_->pop(key_id, find(key_id), ctxt);
+    }
+
+    const DecMetrics& metrics() const
+    {
+        return metrics_;
     }
     
 private:
-    
-    void generate_keyfiles(const std::size_t poly_mod_degree,
-                           const std::size_t coef_mod_192,
-                           const std::size_t plain_mod,
-                           const KeyFilenames& filenames)
+
+    std::shared_ptr<const KeySet> find(const int32_t key_id) const
     {
-        STDSC_LOG_INFO("Generating keys");
-        seal::EncryptionParameters parms(seal::scheme_type::BFV);
-        parms.set_poly_modulus_degree(poly_mod_degree);
-        parms.set_coeff_modulus(seal::DefaultParams::coeff_modulus_192(coef_mod_192));
-        parms.set_plain_modulus(plain_mod);
-
-        auto context = seal::SEALContext::Create(parms);
-        print_parameters(context);
-
-        seal::KeyGenerator keygen(context);
-        seal::PublicKey public_key = keygen.public_key();
-        seal::SecretKey secret_key = keygen.secret_key();
-        auto gal_keys = keygen.galois_keys(16);
-        auto relin_keys16 = keygen.relin_keys(16);
-        seal::BatchEncoder batch_encoder(context);
-
-        size_t slot_count = batch_encoder.slot_count();
-        size_t row_size = slot_count / 2;
-        std::cout << "Plaintext matrix row size: " << row_size << std::endl;
-        std::cout << "Slot nums = " << slot_count << std::endl;
-
-        std::cout << "Save public key and secret key..." << std::flush;
-        std::ofstream pkFile(filenames.filename(KeyKind_t::kKindPubKey), std::ios::binary);
-        public_key.save(pkFile);
-        pkFile.close();
-
-        std::ofstream skFile(filenames.filename(KeyKind_t::kKindSecKey), std::ios::binary);
-        secret_key.save(skFile);
-        skFile.close();
-
-        std::ofstream parmsFile(filenames.filename(KeyKind_t::kKindParam), std::ios::binary);
-        seal::EncryptionParameters::Save(parms, parmsFile);
-        parmsFile.close();
-
-        std::ofstream galFile(filenames.filename(KeyKind_t::kKindGaloisKey), std::ios::binary);
-        gal_keys.save(galFile);
-        galFile.close();
-
-        std::ofstream relinFile(filenames.filename(KeyKind_t::kKindRelinKey), std::ios::binary);
-        relin_keys16.save(relinFile);
-        relinFile.close();
-
-        std::cout << "End" << std::endl;
+        std::shared_lock<std::shared_timed_mutex> lock(mutex_);
+        auto it = map_.find(key_id);
+        if (it == map_.end()) {
+            std::ostringstream oss;
+            oss << "Key is not found. (key ID: " << key_id << ")";
+            STDSC_THROW_INVPARAM(oss.str().c_str());
+        }
+        return it->second;
     }
 
-    void remove_keyfiles(const KeyFilenames& filenames)
+    std::string image_filename(const int32_t key_id) const
+    {
+        return image_dir_ + "/keys_" + std::to_string(key_id) + "." + ImageExt;
+    }
+    
+    void save_image(const int32_t key_id, const KeySet& keyset) const
     {
-        int32_t bgn = static_cast<int32_t>(KeyKind_t::kKindPubKey);
-        int32_t end = static_cast<int32_t>(KeyKind_t::kKindParam);
-
-        for (auto i=bgn; i<=end; ++i) {
-            const auto key = static_cast<KeyKind_t>(i);
-            const auto& filename = filenames.filename(key);
-            auto ret = fts_share::utility::remove_file(filename);
-            if (!ret) {
+        const auto filename = image_filename(key_id);
+        const auto tmpname  = filename + ".tmp";
+        {
+            std::ofstream ofs(tmpname, std::ios::binary);
+            ofs.write(ImageMagic, std::strlen(ImageMagic));
+            ofs.write(reinterpret_cast<const char*>(&key_id), sizeof(key_id));
+            for (const auto& wire : keyset.wire) {
+                const uint64_t sz = wire->size();
+                ofs.write(reinterpret_cast<const char*>(&sz), sizeof(sz));
+            }
+            for (const auto& wire : keyset.wire) {
+                ofs.write(static_cast<const char*>(wire->data()), wire->size());
+            }
+            if (!ofs) {
                 std::ostringstream oss;
-                oss << "Failed to remove file. (" << filename << ")";
+                oss << "Failed to write file. (" << tmpname << ")";
                 STDSC_THROW_FILE(oss.str());
             }
         }
+        // Renamed after written, so that a broken image is never loaded.
+        if (std::rename(tmpname.c_str(), filename.c_str()) != 0) {
+            std::ostringstream oss;
+            oss << "Failed to rename file. (" << tmpname << ")";
+            STDSC_THROW_FILE(oss.str());
+        }
+    }
+
+    void load_images()
+    {
+        const auto files = fts_share::utility::get_filelist(image_dir_, ImageExt);
+        for (const auto& filename : files) {
+            try {
+                load_image(filename);
+            } catch (std::exception& ex) {
+                // A broken body makes SEAL throw standard exceptions.
+                STDSC_LOG_WARN("Skipped key image. (%s: %s)", filename.c_str(), ex.what());
+            }
+        }
+        STDSC_LOG_INFO("Loaded %lu keys from %s.", map_.size(), image_dir_.c_str());
+    }
+
+    void load_image(const std::string& filename)
+    {
+        std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+        if (!ifs) {
+            STDSC_THROW_FILE("Failed to open file.");
+        }
+        const uint64_t file_sz = static_cast<uint64_t>(ifs.tellg());
+        ifs.seekg(0);
+
+        const size_t magic_sz = std::strlen(ImageMagic);
+        std::string magic(magic_sz, '\0');
+        int32_t key_id;
+        std::array<uint64_t, kNumOfKind> sizes;
+        ifs.read(&magic[0], magic_sz);
+        ifs.read(reinterpret_cast<char*>(&key_id), sizeof(key_id));
+        ifs.read(reinterpret_cast<char*>(sizes.data()), sizeof(uint64_t) * kNumOfKind);
+        if (!ifs || magic != ImageMagic) {
+            STDSC_THROW_FILE("Invalid key image.");
+        }
+        if (map_.count(key_id)) {
+            STDSC_THROW_FILE("Key ID is already loaded from another image.");
+        }
+
+        // The keys are read into the buffers to send, and held in memory.
+        auto keyset = std::make_shared<KeySet>();
+        uint64_t offset = magic_sz + sizeof(key_id) + sizeof(uint64_t) * kNumOfKind;
+        for (int32_t k=0; k<kNumOfKind; ++k) {
+            if (sizes[k] > file_sz - offset) {
+                STDSC_THROW_FILE("Truncated key image.");
+            }
+            auto wire = std::make_shared<stdsc::Buffer>(sizes[k]);
+            ifs.read(static_cast<char*>(wire->data()), sizes[k]);
+            keyset->wire[k] = wire;
+            offset += sizes[k];
+        }
+        if (!ifs) {
+            STDSC_THROW_FILE("Failed to read file.");
+        }
+        deserialize_keyset(*keyset);
+        map_[key_id] = keyset;
     }
     
 private:
-    std::unordered_map<int32_t, KeyFilenames> map_;
+    const std::string image_dir_;
+    DecMetrics metrics_;
+    std::shared_ptr<KeyPool> key_pool_;
+    std::shared_ptr<ZeroPool> zero_pool_;
+    mutable std::shared_timed_mutex mutex_;
+    std::unordered_map<int32_t, std::shared_ptr<const KeySet>> map_;
 };
 
-KeyContainer::KeyContainer()
-    : pimpl_(new Impl())
+KeyContainer::KeyContainer(const std::string& image_dir, const size_t key_pool_size,
+                           const size_t zero_pool_depth)
+    : pimpl_(new Impl(image_dir, key_pool_size, zero_pool_depth))
 {}
 
+void KeyContainer::prepare_keys(const fts_share::User2DecParam& param)
+{
+    pimpl_->prepare_keys(param);
+}
+
 int32_t KeyContainer::new_keys(const fts_share::User2DecParam& param)
 {
     auto key_id = pimpl_->new_keys(param);
@@ -229,6 +307,11 @@ void KeyContainer::delete_keys(const int32_t key_id)
     STDSC_LOG_INFO("Deleted key #d.", key_id);
 }
 
+bool KeyContainer::is_exist_key(const int32_t key_id) const
+{
+    return pimpl_->is_exist_key(key_id);
+}
+
 template <class T>
 void KeyContainer::get(const int32_t key_id, const KeyKind_t kind, T& data) const
 {
@@ -255,10 +338,26 @@ size_t KeyContainer::data_size(const int32_t key_id, const KeyKind_t kind) const
     return pimpl_->data_size(key_id, kind);
 }
 
+std::shared_ptr<const stdsc::Buffer>
+KeyContainer::wire_data(const int32_t key_id, const KeyKind_t kind) const
+{
+    return pimpl_->wire_data(key_id, kind);
+}
+
 void KeyContainer::get_param(const int32_t key_id, seal::EncryptionParameters& param) const
 {
     STDSC_LOG_INFO("Get encryption parameters. (key ID: %d)", key_id);
     pimpl_->get_param(key_id, param);
 }
 
+void KeyContainer::encrypt_zero(const int32_t key_id, seal::Ciphertext& ctxt)
+{
+    pimpl_->encrypt_zero(key_id, ctxt);
+}
+
+const DecMetrics& KeyContainer::metrics() const
+{
+    return pimpl_->metrics();
+}
+
 } /* namespace fts_dec */
@@ -19,6 +19,11 @@
 #define FTS_DEC_KEYCONTAINER_HPP
 
 #include <memory>
+#include <string>
+#include <stdsc/stdsc_buffer.hpp>
+#include <fts_share/fts_define.hpp>
+#include <fts_dec/fts_dec_keyset.hpp>
+#include <fts_dec/fts_dec_metrics.hpp>
 #include <seal/seal.h>
 
 namespace fts_share
@@ -29,25 +34,29 @@ namespace fts_share
 namespace fts_dec
 {
 
-enum KeyKind_t : int32_t
-{
-    kKindUnknown   = -1,
-    kKindPubKey    = 0,
-    kKindSecKey    = 1,
-    kKindGaloisKey = 2,
-    kKindRelinKey  = 3,
-    kKindParam     = 4,
-    kNumOfKind,
-};
-    
 /**
- * @brief This class is used to hold the SEAL keys.
+ * @brief This class is used to hold the SEAL keys in memory.
  */
 struct KeyContainer
 {
-    KeyContainer();
+    /**
+     * Constructor
+     * @param[in] image_dir directory to save key images (empty: not saved).
+     *                      The images in the directory are loaded.
+     * @param[in] key_pool_size num of keys to generate in background for each parameters (0: no pool)
+     * @param[in] zero_pool_depth num of encryptions of zero to make in background for each key ID (0: no pool)
+     */
+    explicit KeyContainer(const std::string& image_dir = "",
+                          const size_t key_pool_size = FTS_DEFAULT_KEY_POOL_SIZE,
+                          const size_t zero_pool_depth = FTS_DEFAULT_ZERO_POOL_DEPTH);
     virtual ~KeyContainer() = default;
 
+    /**
+     * Generate keys of parameters in background, so that new keys are given at once.
+     * @param[in] param parameters
+     */
+    void prepare_keys(const fts_share::User2DecParam& param);
+
     /**
      * Generate new keys.
      * @param[in] param parameters
@@ -61,6 +70,13 @@ struct KeyContainer
      */
     void delete_keys(const int32_t key_id);
 
+    /**
+     * Check key ID.
+     * @param[in] key_id key ID
+     * @return exists key ID
+     */
+    bool is_exist_key(const int32_t key_id) const;
+
     /**
      * get keys.
      * @param[in] key_id key ID
@@ -83,6 +99,27 @@ struct KeyContainer
      */
     size_t data_size(const int32_t key_id, const KeyKind_t kind) const;
 
+    /**
+     * get serialized data to send
+     * @param[in] key_id key ID
+     * @param[in] kind key kind
+     * @return serialized data, which is shared and must not be modified
+     */
+    std::shared_ptr<const stdsc::Buffer> wire_data(const int32_t key_id, const KeyKind_t kind) const;
+
+    /**
+     * get a fresh encryption of zero, which is given only once
+     * @param[in] key_id key ID
+     * @param[out] ctxt encryption of zero
+     */
+    void encrypt_zero(const int32_t key_id, seal::Ciphertext& ctxt);
+
+    /**
+     * get counters
+     * @return counters of Decryptor
+     */
+    const DecMetrics& metrics() const;
+
 private:
     struct Impl;
     std::shared_ptr<Impl> pimpl_;
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <deque>
+#include <tuple>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <stdsc/stdsc_log.hpp>
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_share/fts_user2decparam.hpp>
+#include <fts_dec/fts_dec_keyset.hpp>
+#include <fts_dec/fts_dec_keypool.hpp>
+
+#define KEYPOOL_MAX_PARAMS 4
+#define KEYPOOL_NICE 10
+
+namespace fts_dec
+{
+
+struct KeyPool::Impl
+{
+    using Key = std::tuple<size_t, size_t, size_t>;
+    
+    struct Slot
+    {
+        fts_share::User2DecParam param;
+        std::deque<std::shared_ptr<KeySet>> keys;
+        uint64_t last_used;
+    };
+    
+    explicit Impl(const size_t max_keys)
+        : max_keys_(max_keys),
+          tick_(0)
+    {
+    }
+
+    void exec(KeyPoolParam& args, std::shared_ptr<stdsc::ThreadException> te)
+    {
+        STDSC_LOG_INFO("Launched key pool thread. (max keys: %lu)", max_keys_);
+        // Lower the priority of this thread only, so that keys are
+        // generated when the cores are not used by decryption.
+        ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), KEYPOOL_NICE);
+        
+        while (!args.force_finish) {
+            std::shared_ptr<Slot> slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                slot = find_slot_to_fill();
+                if (!slot) {
+                    cond_.wait_for(lock, std::chrono::milliseconds(args.retry_interval_msec));
+                    continue;
+                }
+            }
+
+            std::shared_ptr<KeySet> keyset;
+            try {
+                keyset = generate_keyset(slot->param);
+            } catch (std::exception& ex) {
+                // SEAL throws standard exceptions for invalid parameters.
+                STDSC_LOG_WARN("Failed to generate keys in background. (%s)", ex.what());
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = slots_.find(key_of(slot->param));
+                if (it != slots_.end() && it->second == slot) {
+                    slots_.erase(it);
+                }
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (slot->keys.size() < max_keys_) {
+                    slot->keys.push_back(keyset);
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<Slot> reserve(const fts_share::User2DecParam& param)
+    {
+        auto key = key_of(param);
+        auto it = slots_.find(key);
+        if (it != slots_.end()) {
+            return it->second;
+        }
+        evict_slot_if_needed();
+        auto slot = std::make_shared<Slot>();
+        slot->param = param;
+        slot->last_used = ++tick_;
+        slots_.emplace(key, slot);
+        cond_.notify_all();
+        return slot;
+    }
+    
+    std::shared_ptr<KeySet> pop(const fts_share::User2DecParam& param)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = slots_.find(key_of(param));
+            if (it != slots_.end()) {
+                auto slot = it->second;
+                slot->last_used = ++tick_;
+
+                if (!slot->keys.empty()) {
+                    auto keyset = slot->keys.front();
+                    slot->keys.pop_front();
+                    cond_.notify_all();
+                    STDSC_LOG_INFO("Got keys from pool. (remaining: %lu)", slot->keys.size());
+                    return keyset;
+                }
+            }
+        }
+
+        STDSC_LOG_INFO("Key pool is empty. Generate keys on the spot.");
+        auto keyset = generate_keyset(param);
+
+        // The slot is made after the keys are generated, so that the
+        // pool never holds the parameters which SEAL rejects.
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reserve(param)->last_used = ++tick_;
+        }
+        return keyset;
+    }
+
+    static Key key_of(const fts_share::User2DecParam& param)
+    {
+        return Key(param.poly_mod_degree, param.coef_mod_192, param.plain_mod);
+    }
+    
+    std::shared_ptr<Slot> find_slot_to_fill() const
+    {
+        std::shared_ptr<Slot> slot;
+        for (const auto& pair : slots_) {
+            const auto& s = pair.second;
+            if (s->keys.size() < max_keys_ &&
+                (!slot || s->keys.size() < slot->keys.size())) {
+                slot = s;
+            }
+        }
+        return slot;
+    }
+
+    void evict_slot_if_needed()
+    {
+        while (slots_.size() >= KEYPOOL_MAX_PARAMS) {
+            auto oldest = slots_.begin();
+            for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+                if (it->second->last_used < oldest->second->last_used) {
+                    oldest = it;
+                }
+            }
+            slots_.erase(oldest);
+        }
+    }
+
+    const size_t max_keys_;
+    uint64_t tick_;
+    std::map<Key, std::shared_ptr<Slot>> slots_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    KeyPoolParam param_;
+    std::shared_ptr<stdsc::ThreadException> te_;
+};
+
+KeyPool::KeyPool(const size_t max_keys)
+    : pimpl_(new Impl(max_keys))
+{}
+
+void KeyPool::start()
+{
+    pimpl_->param_.force_finish = false;
+    super::start(pimpl_->param_, pimpl_->te_);
+}
+
+void KeyPool::stop()
+{
+    STDSC_LOG_INFO("Stop key pool thread.");
+    pimpl_->param_.force_finish = true;
+    pimpl_->cond_.notify_all();
+}
+
+void KeyPool::reserve(const fts_share::User2DecParam& param)
+{
+    std::lock_guard<std::mutex> lock(pimpl_->mutex_);
+    pimpl_->reserve(param);
+}
+
+std::shared_ptr<KeySet> KeyPool::pop(const fts_share::User2DecParam& param)
+{
+    return pimpl_->pop(param);
+}
+
+void KeyPool::exec(KeyPoolParam& args, std::shared_ptr<stdsc::ThreadException> te) const
+{
+    pimpl_->exec(args, te);
+}
+
+} /* namespace fts_dec */
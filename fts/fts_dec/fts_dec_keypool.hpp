@@ -0,0 +1,97 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_DEC_KEYPOOL_HPP
+#define FTS_DEC_KEYPOOL_HPP
+
+#include <memory>
+#include <stdsc/stdsc_thread.hpp>
+#include <fts_share/fts_define.hpp>
+
+namespace fts_share
+{
+    class User2DecParam;
+}
+
+namespace fts_dec
+{
+
+class KeyPoolParam;
+struct KeySet;
+
+/**
+ * @brief Provides the pool of keys generated in background.
+ *        The pool holds keys for each of encryption parameters which have
+ *        been requested, and the thread runs at low priority so that keys
+ *        are generated on idle cores.
+ */
+class KeyPool : public stdsc::Thread<KeyPoolParam>
+{
+    using super = Thread<KeyPoolParam>;
+public:
+    /**
+     * Constructor
+     * @param[in] max_keys max number of keys to hold for each parameters
+     */
+    explicit KeyPool(const size_t max_keys = FTS_DEFAULT_KEY_POOL_SIZE);
+    virtual ~KeyPool(void) = default;
+
+    /**
+     * Start thread
+     */
+    void start();
+
+    /**
+     * Stop thread
+     */
+    void stop();
+
+    /**
+     * Prepare keys of parameters in background
+     * @param[in] param parameters
+     */
+    void reserve(const fts_share::User2DecParam& param);
+
+    /**
+     * Get keys. The keys are generated on the spot if the pool is empty.
+     * @param[in] param parameters
+     * @return keys
+     */
+    std::shared_ptr<KeySet> pop(const fts_share::User2DecParam& param);
+
+private:
+    virtual void exec(KeyPoolParam& args,
+                      std::shared_ptr<stdsc::ThreadException> te) const override;
+
+    struct Impl;
+    std::shared_ptr<Impl> pimpl_;
+};
+
+/**
+ * @brief This class is used to hold the parameters for KeyPool.
+ */
+struct KeyPoolParam
+{
+    uint32_t retry_interval_msec = DefaultRetryIntervalMsec;
+    bool force_finish = false;
+
+    static constexpr uint32_t DefaultRetryIntervalMsec = 100;
+};
+
+} /* namespace fts_dec */
+
+#endif /* FTS_DEC_KEYPOOL_HPP */
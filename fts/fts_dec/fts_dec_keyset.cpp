@@ -0,0 +1,144 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <sstream>
+#include <iostream>
+#include <stdsc/stdsc_exception.hpp>
+#include <stdsc/stdsc_log.hpp>
+#include <fts_share/fts_user2decparam.hpp>
+#include <fts_share/fts_seal_utility.hpp>
+#include <fts_dec/fts_dec_keyset.hpp>
+
+namespace fts_dec
+{
+
+static void print_parameters(std::shared_ptr<seal::SEALContext> context)
+{
+    // Verify parameters
+    STDSC_THROW_INVPARAM_IF_CHECK(context, "context is not set");
+    auto &context_data = *context->context_data();
+
+    //Which scheme are we using?
+    std::string scheme_name;
+    switch (context_data.parms().scheme())
+    {
+    case seal::scheme_type::BFV:
+        scheme_name = "BFV";
+        break;
+    case seal::scheme_type::CKKS:
+        scheme_name = "CKKS";
+        break;
+    default:
+        STDSC_THROW_INVARIANT("unsupported scheme");
+    }
+
+    std::cout << "/ Encryption parameters:" << std::endl;
+    std::cout << "| scheme: " << scheme_name << std::endl;
+    std::cout << "| poly_modulus_degree: " <<
+        context_data.parms().poly_modulus_degree() << std::endl;
+
+    //Print the size of the true (product) coefficient modulus.
+    std::cout << "| coeff_modulus size: " << context_data.
+        total_coeff_modulus_bit_count() << " bits" << std::endl;
+
+    //For the BFV scheme print the plain_modulus parameter.
+    if (context_data.parms().scheme() == seal::scheme_type::BFV)  {
+        std::cout << "| plain_modulus: " << context_data.
+            parms().plain_modulus().value() << std::endl;
+    }
+
+    std::cout << "\\ noise_standard_deviation: " << context_data.
+        parms().noise_standard_deviation() << std::endl;
+    std::cout << std::endl;
+}
+
+static std::shared_ptr<stdsc::Buffer> to_buffer(const std::ostringstream& oss)
+{
+    const auto str = oss.str();
+    auto buffer = std::make_shared<stdsc::Buffer>(str.size());
+    std::memcpy(buffer->data(), str.data(), str.size());
+    return buffer;
+}
+
+template <class T>
+static std::shared_ptr<stdsc::Buffer> serialize(const T& data)
+{
+    std::ostringstream oss;
+    data.save(oss);
+    return to_buffer(oss);
+}
+
+std::shared_ptr<KeySet> generate_keyset(const fts_share::User2DecParam& param)
+{
+    STDSC_LOG_INFO("Generating keys");
+    auto keyset = std::make_shared<KeySet>();
+    auto& parms = keyset->params;
+    parms.set_poly_modulus_degree(param.poly_mod_degree);
+    parms.set_coeff_modulus(seal::DefaultParams::coeff_modulus_192(param.coef_mod_192));
+    parms.set_plain_modulus(param.plain_mod);
+
+    auto context = seal::SEALContext::Create(parms);
+    print_parameters(context);
+
+    seal::KeyGenerator keygen(context);
+    keyset->pubkey = keygen.public_key();
+    keyset->seckey = keygen.secret_key();
+    seal::BatchEncoder batch_encoder(context);
+
+    size_t slot_count = batch_encoder.slot_count();
+    size_t row_size = slot_count / 2;
+    std::cout << "Plaintext matrix row size: " << row_size << std::endl;
+    std::cout << "Slot nums = " << slot_count << std::endl;
+
+    // The keys are serialized once here, and sent as they are.
+    auto& wire = keyset->wire;
+    wire[kKindPubKey]    = serialize(keyset->pubkey);
+    wire[kKindSecKey]    = serialize(keyset->seckey);
+    // Only the galois keys of the steps used by computation server.
+    const auto steps = fts_share::seal_utility::rotation_steps(param.poly_mod_degree);
+    wire[kKindGaloisKey] = serialize(keygen.galois_keys(16, steps));
+    wire[kKindRelinKey]  = serialize(keygen.relin_keys(16));
+    {
+        std::ostringstream oss;
+        seal::EncryptionParameters::Save(parms, oss);
+        wire[kKindParam] = to_buffer(oss);
+    }
+    return keyset;
+}
+
+void deserialize_keyset(KeySet& keyset)
+{
+    const auto& wire = keyset.wire;
+    {
+        MemoryStreamBuf buf(wire[kKindParam]->data(), wire[kKindParam]->size());
+        std::istream is(&buf);
+        keyset.params = seal::EncryptionParameters::Load(is);
+    }
+    {
+        MemoryStreamBuf buf(wire[kKindSecKey]->data(), wire[kKindSecKey]->size());
+        std::istream is(&buf);
+        keyset.seckey.unsafe_load(is);
+    }
+    {
+        MemoryStreamBuf buf(wire[kKindPubKey]->data(), wire[kKindPubKey]->size());
+        std::istream is(&buf);
+        keyset.pubkey.unsafe_load(is);
+    }
+}
+
+} /* namespace fts_dec */
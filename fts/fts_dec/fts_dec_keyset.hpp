@@ -0,0 +1,86 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_DEC_KEYSET_HPP
+#define FTS_DEC_KEYSET_HPP
+
+#include <array>
+#include <memory>
+#include <streambuf>
+#include <stdsc/stdsc_buffer.hpp>
+#include <seal/seal.h>
+
+namespace fts_share
+{
+    class User2DecParam;
+}
+
+namespace fts_dec
+{
+
+enum KeyKind_t : int32_t
+{
+    kKindUnknown   = -1,
+    kKindPubKey    = 0,
+    kKindSecKey    = 1,
+    kKindGaloisKey = 2,
+    kKindRelinKey  = 3,
+    kKindParam     = 4,
+    kNumOfKind,
+};
+
+/**
+ * @brief This class is used to hold a set of keys. Each kind of keys is
+ * held in serialized form to send as it is, and the keys used by Decryptor
+ * are also held in deserialized form.
+ */
+struct KeySet
+{
+    seal::EncryptionParameters params = seal::EncryptionParameters(seal::scheme_type::BFV);
+    seal::SecretKey seckey;
+    seal::PublicKey pubkey;
+    std::array<std::shared_ptr<stdsc::Buffer>, kNumOfKind> wire;
+};
+
+/**
+ * Generate new keys.
+ * @param[in] param parameters
+ * @return keys
+ */
+std::shared_ptr<KeySet> generate_keyset(const fts_share::User2DecParam& param);
+
+/**
+ * Load the deserialized keys from the serialized keys.
+ * @param[in,out] keyset keys
+ */
+void deserialize_keyset(KeySet& keyset);
+
+/**
+ * @brief Provides the stream buffer to read memory without copy.
+ */
+struct MemoryStreamBuf : public std::streambuf
+{
+    MemoryStreamBuf(const void* data, const size_t size)
+    {
+        auto* p = static_cast<char*>(const_cast<void*>(data));
+        setg(p, p, p + size);
+    }
+};
+
+} /* namespace fts_dec */
+
+#endif /* FTS_DEC_KEYSET_HPP */
@@ -15,9 +15,25 @@
  * limitations under the License.
  */
 
-#ifndef FTS_COMMONPARAM_HPP
-#define FTS_COMMONPARAM_HPP
+#ifndef FTS_DEC_METRICS_HPP
+#define FTS_DEC_METRICS_HPP
 
-#define FTS_COMMONPARAM_NTHREADS (12)  // The number of threads to calcurate on decryptor/cs
+#include <atomic>
+#include <cstdint>
 
-#endif /* FTS_COMMONPARAM_HPP */
+namespace fts_dec
+{
+
+/**
+ * @brief This class is used to hold the counters of Decryptor.
+ */
+struct DecMetrics
+{
+    std::atomic<uint64_t> zero_pool_hits   {0}; // encryptions of zero taken from the pool
+    std::atomic<uint64_t> zero_pool_misses {0}; // encryptions of zero made on the spot
+    std::atomic<uint64_t> zero_pool_depth  {0}; // encryptions of zero held, as of the last pop
+};
+
+} /* namespace fts_dec */
+
+#endif /* FTS_DEC_METRICS_HPP */
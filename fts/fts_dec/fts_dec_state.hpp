@@ -48,6 +48,8 @@ enum Event_t : uint64_t
     kEventRelinKeyRequest   = 5,
     kEventParamRequest      = 6,
     kEventCsMidResult       = 7,
+    kEventPingRequest       = 8,
+    kEventKeyCheckRequest   = 9,
 };
 
 /**
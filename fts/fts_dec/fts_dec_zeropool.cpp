@@ -0,0 +1,254 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <stdsc/stdsc_log.hpp>
+#include <stdsc/stdsc_exception.hpp>
+#include <fts_dec/fts_dec_keyset.hpp>
+#include <fts_dec/fts_dec_metrics.hpp>
+#include <fts_dec/fts_dec_zeropool.hpp>
+#include <seal/seal.h>
+
+#define ZEROPOOL_MAX_KEYS 16
+#define ZEROPOOL_NICE 10
+
+namespace fts_dec
+{
+
+struct ZeroPool::Impl
+{
+    struct Slot
+    {
+        std::shared_ptr<const KeySet> keyset;
+        std::shared_ptr<seal::Encryptor> encryptor;
+        std::deque<seal::Ciphertext> zeros;
+        uint64_t last_used;
+    };
+    
+    Impl(DecMetrics& metrics, const size_t depth)
+        : metrics_(metrics),
+          depth_(depth),
+          tick_(0),
+          num_zeros_(0)
+    {
+    }
+
+    void exec(ZeroPoolParam& args, std::shared_ptr<stdsc::ThreadException> te)
+    {
+        STDSC_LOG_INFO("Launched zero pool thread. (depth: %lu)", depth_);
+        // Lower the priority of this thread only, so that the ciphertexts
+        // are encrypted when the cores are not used by decryption.
+        ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), ZEROPOOL_NICE);
+        
+        while (!args.force_finish) {
+            std::shared_ptr<Slot> slot;
+            std::shared_ptr<const KeySet> keyset;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                slot = find_slot_to_fill();
+                if (!slot) {
+                    cond_.wait_for(lock, std::chrono::milliseconds(args.retry_interval_msec));
+                    continue;
+                }
+                keyset = slot->keyset;
+            }
+
+            seal::Ciphertext ctxt;
+            try {
+                // The encryptor is used only by this thread.
+                if (!slot->encryptor) {
+                    slot->encryptor = make_encryptor(*keyset);
+                }
+                encrypt_zero(*slot->encryptor, ctxt);
+            } catch (std::exception& ex) {
+                STDSC_LOG_WARN("Failed to encrypt zero in background. (%s)", ex.what());
+                std::lock_guard<std::mutex> lock(mutex_);
+                erase(slot);
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                // The slot may have been erased while encrypting.
+                if (slot->keyset && slot->zeros.size() < depth_) {
+                    slot->zeros.push_back(std::move(ctxt));
+                    ++num_zeros_;
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<Slot> reserve(const int32_t key_id, std::shared_ptr<const KeySet> keyset)
+    {
+        if (depth_ == 0) {
+            return nullptr;
+        }
+        auto it = slots_.find(key_id);
+        if (it != slots_.end()) {
+            return it->second;
+        }
+        evict_slot_if_needed();
+        auto slot = std::make_shared<Slot>();
+        slot->keyset = keyset;
+        slot->last_used = ++tick_;
+        slots_.emplace(key_id, slot);
+        cond_.notify_all();
+        return slot;
+    }
+    
+    void pop(const int32_t key_id, std::shared_ptr<const KeySet> keyset,
+             seal::Ciphertext& ctxt)
+    {
+        if (depth_ > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto slot = reserve(key_id, keyset);
+            slot->last_used = ++tick_;
+
+            if (!slot->zeros.empty()) {
+                ctxt = std::move(slot->zeros.front());
+                slot->zeros.pop_front();
+                --num_zeros_;
+                ++metrics_.zero_pool_hits;
+                metrics_.zero_pool_depth = num_zeros_;
+                cond_.notify_all();
+                return;
+            }
+            metrics_.zero_pool_depth = num_zeros_;
+        }
+        cond_.notify_all();
+
+        ++metrics_.zero_pool_misses;
+        encrypt_zero(*make_encryptor(*keyset), ctxt);
+    }
+
+    void erase(const int32_t key_id)
+    {
+        auto it = slots_.find(key_id);
+        if (it != slots_.end()) {
+            erase(it->second);
+        }
+    }
+    
+    void erase(std::shared_ptr<Slot> slot)
+    {
+        for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+            if (it->second == slot) {
+                num_zeros_ -= slot->zeros.size();
+                slot->zeros.clear();
+                slot->keyset.reset();
+                slots_.erase(it);
+                break;
+            }
+        }
+    }
+
+    static std::shared_ptr<seal::Encryptor> make_encryptor(const KeySet& keyset)
+    {
+        auto context = seal::SEALContext::Create(keyset.params);
+        return std::make_shared<seal::Encryptor>(context, keyset.pubkey);
+    }
+    
+    static void encrypt_zero(seal::Encryptor& encryptor, seal::Ciphertext& ctxt)
+    {
+        seal::Plaintext zero("0");
+        encryptor.encrypt(zero, ctxt);
+    }
+    
+    std::shared_ptr<Slot> find_slot_to_fill() const
+    {
+        std::shared_ptr<Slot> slot;
+        for (const auto& pair : slots_) {
+            const auto& s = pair.second;
+            if (s->zeros.size() < depth_ &&
+                (!slot || s->zeros.size() < slot->zeros.size())) {
+                slot = s;
+            }
+        }
+        return slot;
+    }
+
+    void evict_slot_if_needed()
+    {
+        while (slots_.size() >= ZEROPOOL_MAX_KEYS) {
+            auto oldest = slots_.begin();
+            for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+                if (it->second->last_used < oldest->second->last_used) {
+                    oldest = it;
+                }
+            }
+            erase(oldest->second);
+        }
+    }
+
+    DecMetrics& metrics_;
+    const size_t depth_;
+    uint64_t tick_;
+    size_t num_zeros_;
+    std::map<int32_t, std::shared_ptr<Slot>> slots_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    ZeroPoolParam param_;
+    std::shared_ptr<stdsc::ThreadException> te_;
+};
+
+ZeroPool::ZeroPool(DecMetrics& metrics, const size_t depth)
+    : pimpl_(new Impl(metrics, depth))
+{}
+
+void ZeroPool::start()
+{
+    pimpl_->param_.force_finish = false;
+    super::start(pimpl_->param_, pimpl_->te_);
+}
+
+void ZeroPool::stop()
+{
+    STDSC_LOG_INFO("Stop zero pool thread.");
+    pimpl_->param_.force_finish = true;
+    pimpl_->cond_.notify_all();
+}
+
+void ZeroPool::reserve(const int32_t key_id, std::shared_ptr<const KeySet> keyset)
+{
+    std::lock_guard<std::mutex> lock(pimpl_->mutex_);
+    pimpl_->reserve(key_id, keyset);
+}
+
+void ZeroPool::pop(const int32_t key_id, std::shared_ptr<const KeySet> keyset,
+                   seal::Ciphertext& ctxt)
+{
+    pimpl_->pop(key_id, keyset, ctxt);
+}
+
+void ZeroPool::erase(const int32_t key_id)
+{
+    std::lock_guard<std::mutex> lock(pimpl_->mutex_);
+    pimpl_->erase(key_id);
+}
+
+void ZeroPool::exec(ZeroPoolParam& args, std::shared_ptr<stdsc::ThreadException> te) const
+{
+    pimpl_->exec(args, te);
+}
+
+} /* namespace fts_dec */
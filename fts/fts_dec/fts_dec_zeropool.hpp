@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_DEC_ZEROPOOL_HPP
+#define FTS_DEC_ZEROPOOL_HPP
+
+#include <memory>
+#include <stdsc/stdsc_thread.hpp>
+#include <fts_share/fts_define.hpp>
+
+namespace seal
+{
+    class Ciphertext;
+}
+
+namespace fts_dec
+{
+
+class ZeroPoolParam;
+struct KeySet;
+struct DecMetrics;
+
+/**
+ * @brief Provides the pool of encryptions of zero made in background.
+ *        The pool holds the ciphertexts for each of key IDs which have
+ *        been used, so that a PIR query is made by adding the plaintext to
+ *        the ciphertext instead of encrypting it. Each ciphertext is given
+ *        only once.
+ */
+class ZeroPool : public stdsc::Thread<ZeroPoolParam>
+{
+    using super = Thread<ZeroPoolParam>;
+public:
+    /**
+     * Constructor
+     * @param[in,out] metrics counters of Decryptor
+     * @param[in] depth max number of ciphertexts to hold for each key ID
+     */
+    explicit ZeroPool(DecMetrics& metrics,
+                      const size_t depth = FTS_DEFAULT_ZERO_POOL_DEPTH);
+    virtual ~ZeroPool(void) = default;
+
+    /**
+     * Start thread
+     */
+    void start();
+
+    /**
+     * Stop thread
+     */
+    void stop();
+
+    /**
+     * Prepare encryptions of zero of key ID in background
+     * @param[in] key_id key ID
+     * @param[in] keyset keys
+     */
+    void reserve(const int32_t key_id, std::shared_ptr<const KeySet> keyset);
+
+    /**
+     * Get an encryption of zero. It is encrypted on the spot if the pool is empty.
+     * @param[in] key_id key ID
+     * @param[in] keyset keys
+     * @param[out] ctxt encryption of zero
+     */
+    void pop(const int32_t key_id, std::shared_ptr<const KeySet> keyset,
+             seal::Ciphertext& ctxt);
+
+    /**
+     * Discard encryptions of zero of key ID
+     * @param[in] key_id key ID
+     */
+    void erase(const int32_t key_id);
+
+private:
+    virtual void exec(ZeroPoolParam& args,
+                      std::shared_ptr<stdsc::ThreadException> te) const override;
+
+    struct Impl;
+    std::shared_ptr<Impl> pimpl_;
+};
+
+/**
+ * @brief This class is used to hold the parameters for ZeroPool.
+ */
+struct ZeroPoolParam
+{
+    uint32_t retry_interval_msec = DefaultRetryIntervalMsec;
+    bool force_finish = false;
+
+    static constexpr uint32_t DefaultRetryIntervalMsec = 100;
+};
+
+} /* namespace fts_dec */
+
+#endif /* FTS_DEC_ZEROPOOL_HPP */
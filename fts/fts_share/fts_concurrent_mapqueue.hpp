@@ -20,90 +20,243 @@
 
 #include <map>
 #include <mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
 #include <cstdbool>
+#include <functional>
+#include <condition_variable>
 #include <stdsc/stdsc_exception.hpp>
 
 namespace fts_share
 {
 
-template <class Tk, class Tv>
+/**
+ * @brief Provides the keyed queue shared by many producers and consumers.
+ *
+ * Elements are distributed over 'NumShards' shards by hash of key, and each
+ * shard has its own lock, so that operations on different keys rarely contend.
+ * The front of queue is the smallest key of a shard, and shards are visited
+ * in round robin, so the order of pop is approximately ordered by key.
+ * size() is kept by an atomic counter and is consistent with completed
+ * pushes and pops. Iteration is provided by snapshot and for_each,
+ * which are safe against concurrent modification.
+ */
+template <class Tk, class Tv, size_t NumShards = 16>
 class ConcurrentMapQueue
 {
 public:
-    ConcurrentMapQueue() = default;
+    ConcurrentMapQueue() : size_(0), next_shard_(0) {}
     virtual ~ConcurrentMapQueue() = default;
 
     virtual void push(const Tk& key, const Tv& val)
     {
-        STDSC_THROW_INVPARAM_IF_CHECK(!map_.count(key), "key has already exist.");
-        std::lock_guard<std::mutex> lock(mtx_);
-        map_.emplace(key, val);
+        auto& shard = shard_of(key);
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            STDSC_THROW_INVPARAM_IF_CHECK(!shard.map.count(key), "key has already exist.");
+            shard.map.emplace(key, val);
+            ++size_;
+            auto it = shard.waiters.find(key);
+            if (it != shard.waiters.end()) {
+                it->second->cond.notify_all();
+            }
+        }
+        {
+            // taken to avoid lost wake-up of the front waiters
+            std::lock_guard<std::mutex> lock(front_mtx_);
+        }
+        front_cond_.notify_one();
     }
 
     virtual size_t size() const
     {
-        return map_.size();
+        return size_.load();
     }
 
-    virtual typename std::map<Tk, Tv>::iterator begin()
+    virtual size_t count(const Tk& key) const
     {
-        return map_.begin();
+        auto& shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        return shard.map.count(key);
     }
 
-    virtual typename std::map<Tk, Tv>::iterator end()
+    /**
+     * Get copy of all elements
+     * @return elements
+     */
+    virtual std::vector<std::pair<Tk, Tv>> snapshot() const
     {
-        return map_.end();
+        std::vector<std::pair<Tk, Tv>> elems;
+        elems.reserve(size());
+        for_each([&elems](const Tk& key, const Tv& val) {
+            elems.emplace_back(key, val);
+        });
+        return elems;
     }
-    
-    virtual size_t count(const Tk& key) const
+
+    /**
+     * Call function for each element. Each shard is locked while the
+     * function is called for its elements, so the function must not
+     * access this queue.
+     * @param[in] func function
+     */
+    virtual void for_each(const std::function<void(const Tk&, const Tv&)>& func) const
     {
-        return map_.count(key);
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            for (const auto& pair : shard.map) {
+                func(pair.first, pair.second);
+            }
+        }
     }
     
     virtual bool pop(Tk& key, Tv& val)
     {
-        std::lock_guard<std::mutex> lock(mtx_);
-
-        if (0 == map_.size()) {
+        if (0 == size()) {
             return false;
         }
 
-        const auto front = map_.begin();
-        key = front->first;
-        val = front->second;
-        map_.erase(front);
-        return true;
+        const size_t start = next_shard_++;
+        for (size_t i=0; i<NumShards; ++i) {
+            auto& shard = shards_[(start + i) % NumShards];
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            if (shard.map.empty()) {
+                continue;
+            }
+            const auto front = shard.map.begin();
+            key = front->first;
+            on_erase(front->first, front->second);
+            val = std::move(front->second);
+            shard.map.erase(front);
+            --size_;
+            return true;
+        }
+        return false;
     }
 
     virtual bool pop(const Tk& key, Tv& val)
     {
-        std::lock_guard<std::mutex> lock(mtx_);
-        
-        if (0 == map_.size() || 0 == map_.count(key)) {
-            return false;
+        auto& shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        return take(shard, key, val);
+    }
+
+    /**
+     * Pop the front element. Blocks until an element is pushed or timed out.
+     * @param[out] key key
+     * @param[out] val value
+     * @param[in] timeout_msec timeout (msec)
+     * @return false if timed out
+     */
+    virtual bool wait_pop(Tk& key, Tv& val, const uint32_t timeout_msec)
+    {
+        const auto deadline = std::chrono::steady_clock::now()
+            + std::chrono::milliseconds(timeout_msec);
+        while (!pop(key, val)) {
+            std::unique_lock<std::mutex> lock(front_mtx_);
+            if (!front_cond_.wait_until(lock, deadline, [this]{ return size() > 0; })) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Pop the element of key. Blocks until the element is pushed or timed out.
+     * Only the waiters of the key are woken up by the push.
+     * @param[in] key key
+     * @param[out] val value
+     * @param[in] timeout_msec timeout (msec)
+     * @return false if timed out
+     */
+    virtual bool wait_pop(const Tk& key, Tv& val, const uint32_t timeout_msec)
+    {
+        auto& shard = shard_of(key);
+        std::unique_lock<std::mutex> lock(shard.mtx);
+
+        auto& waiter = shard.waiters[key];
+        if (!waiter) {
+            waiter = std::make_shared<Waiter>();
+        }
+        auto w = waiter;
+        ++w->num;
+        const bool found = w->cond.wait_for(lock, std::chrono::milliseconds(timeout_msec),
+                                            [&shard, &key]{ return shard.map.count(key) > 0; });
+        if (--w->num == 0) {
+            shard.waiters.erase(key);
         }
         
-        val = map_.at(key);
-        map_.erase(key);
-        
-        return true;        
+        return found && take(shard, key, val);
     }
 
     virtual bool get(const Tk& key, Tv& val)
     {
-        std::lock_guard<std::mutex> lock(mtx_);
+        auto& shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
         
-        if (0 == map_.size() || 0 == map_.count(key)) {
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
             return false;
         }
         
-        val = map_.at(key);
+        val = it->second;
         return true;        
     }
 
+protected:
+    /**
+     * Called when an element is removed, with the lock of its shard held.
+     * The derived classes must not access this queue in it.
+     * @param[in] key key
+     * @param[in] val value
+     */
+    virtual void on_erase(const Tk& key, const Tv& val) {}
+
 private:
-    std::map<Tk, Tv> map_;
-    std::mutex mtx_;
+    struct Waiter
+    {
+        size_t num = 0;
+        std::condition_variable cond;
+    };
+
+    struct Shard
+    {
+        std::map<Tk, Tv> map;
+        std::map<Tk, std::shared_ptr<Waiter>> waiters;
+        mutable std::mutex mtx;
+    };
+
+    Shard& shard_of(const Tk& key)
+    {
+        return shards_[std::hash<Tk>()(key) % NumShards];
+    }
+
+    const Shard& shard_of(const Tk& key) const
+    {
+        return shards_[std::hash<Tk>()(key) % NumShards];
+    }
+
+    bool take(Shard& shard, const Tk& key, Tv& val)
+    {
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            return false;
+        }
+        on_erase(it->first, it->second);
+        val = std::move(it->second);
+        shard.map.erase(it);
+        --size_;
+        return true;
+    }
+
+    std::array<Shard, NumShards> shards_;
+    std::atomic<size_t> size_;
+    std::atomic<size_t> next_shard_;
+    std::mutex front_mtx_;
+    std::condition_variable front_cond_;
 };
 
 } /* namespace fts_share */
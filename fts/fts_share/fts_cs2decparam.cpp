@@ -27,6 +27,7 @@ std::ostream& operator<<(std::ostream& os, const Cs2DecParam& param)
     os << param.key_id                       << std::endl;
     os << param.query_id                     << std::endl;
     os << param.possible_input_num_one       << std::endl;
+    os << param.packed_rows_one              << std::endl;
     os << param.possible_input_num_two       << std::endl;
     os << param.possible_combination_num_two << std::endl;
     return os;
@@ -39,6 +40,7 @@ std::istream& operator>>(std::istream& is, Cs2DecParam& param)
     is >> param.key_id;
     is >> param.query_id;
     is >> param.possible_input_num_one;
+    is >> param.packed_rows_one;
     is >> param.possible_input_num_two;
     is >> param.possible_combination_num_two;
     param.func_no = static_cast<fts_share::FuncNo_t>(i32_func_no);
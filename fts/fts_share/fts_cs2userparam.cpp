@@ -24,6 +24,7 @@ std::ostream& operator<<(std::ostream& os, const Cs2UserParam& param)
 {
     auto i32_result = static_cast<int32_t>(param.result);
     os << i32_result << std::endl;
+    os << param.retry_after_msec << std::endl;
     return os;
 }
 
@@ -31,6 +32,7 @@ std::istream& operator>>(std::istream& is, Cs2UserParam& param)
 {
     int32_t i32_result;
     is >> i32_result;
+    is >> param.retry_after_msec;
     param.result = static_cast<CsCalcResult_t>(i32_result);
     return is;
 }
@@ -19,6 +19,7 @@
 #define FTS_CS2USERPARAM_HPP
 
 #include <iostream>
+#include <cstdint>
 
 namespace fts_share
 {
@@ -31,6 +32,9 @@ enum CsCalcResult_t : int32_t
     kCsCalcResultNil     = -1,
     kCsCalcResultSuccess = 0,
     kCsCalcResultFailed  = 1,
+    kCsCalcResultPending = 2,
+    kCsCalcResultRejected = 3, // query is rejected by overload, retry later
+    kCsCalcResultNotFound = 4, // query is unknown, cancelled or its result is deleted
 };
 
 /**
@@ -39,6 +43,7 @@ enum CsCalcResult_t : int32_t
 struct Cs2UserParam
 {
     CsCalcResult_t result = kCsCalcResultNil;
+    uint32_t retry_after_msec = 0; // time to retry after if rejected (msec)
 };
 
 std::ostream& operator<<(std::ostream& os, const Cs2UserParam& param);
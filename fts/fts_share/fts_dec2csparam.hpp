@@ -31,6 +31,7 @@ enum DecCalcResult_t : int32_t
     kDecCalcResultNil                   = -1,
     kDecCalcResultSuccess               = 0,
     kDecCalcResultErrNoFoundInputMember = 1,
+    kDecCalcResultErrNoFoundKeyID       = 2,
 };
 
 /**
@@ -7,10 +7,35 @@
 #define FTS_DEFAULT_MAX_CONCURRENT_QUERIES 128
 #define FTS_DEFAULT_MAX_RESULTS 128
 #define FTS_DEFAULT_MAX_RESULT_LIFETIME_SEC 50000
+#define FTS_DEFAULT_MAX_RESULT_BYTES (1UL * 1024 * 1024 * 1024)
+#define FTS_RESULT_REAP_INTERVAL_MSEC 1000
+#define FTS_DEFAULT_MAX_INFLIGHT_BYTES (8UL * 1024 * 1024 * 1024)
+#define FTS_DEFAULT_MAX_INFLIGHT_COST (64.0 * FTS_LUT_POSSIBLE_INPUT_NUM_TWO * FTS_LUT_POSSIBLE_INPUT_NUM_TWO)
+#define FTS_DEFAULT_RETRY_AFTER_MSEC 1000
+#define FTS_MIN_RETRY_AFTER_MSEC 100
+#define FTS_MAX_RETRY_AFTER_MSEC 30000
+#define FTS_DEFAULT_QUERY_RETRIES 8
+#define FTS_QUERY_RETRY_BASE_MSEC 100
+#define FTS_DEFAULT_KEY_POOL_SIZE 2
+#define FTS_DEFAULT_ZERO_POOL_DEPTH 6
+#define FTS_DEFAULT_MAX_CACHED_KEYS 16
+#define FTS_DEFAULT_MAX_CACHED_KEY_BYTES (8UL * 1024 * 1024 * 1024)
+#define FTS_DEFAULT_MAX_LUT_BUNDLES 4
+#define FTS_DEFAULT_MAX_QUERY_BYTES (2UL * 1024 * 1024 * 1024)
+#define FTS_DEFAULT_PACKED_ROWS 1
+#define FTS_DEFAULT_KEYFETCH_THREADS 1
+#define FTS_DEFAULT_COMPUTEA_THREADS 2
+#define FTS_DEFAULT_DECEXCHANGE_THREADS 4
+#define FTS_DEFAULT_COMPUTEB_THREADS 2
+#define FTS_DEC_HEALTH_CHECK_INTERVAL_SEC 30
+#define FTS_DEFAULT_RESULT_POLL_MSEC 1000
+#define FTS_MAX_RESULT_POLL_MSEC 10000
 
 #define FTS_LUTFILE_EXT "csv"
 
 #define FTS_LUT_POSSIBLE_INPUT_NUM_ONE (819200)
 #define FTS_LUT_POSSIBLE_INPUT_NUM_TWO (4096)
+#define FTS_LUT_DUMMY_INPUT (100)
+#define FTS_LUT_DUMMY_OUTPUT (1000)
 
 #endif /* FTS_DEFINE_HPP */
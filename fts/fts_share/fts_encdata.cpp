@@ -20,7 +20,6 @@
 #include <stdsc/stdsc_exception.hpp>
 #include <stdsc/stdsc_log.hpp>
 #include <fts_share/fts_utility.hpp>
-#include <fts_share/fts_commonparam.hpp>
 #include <fts_share/fts_encdata.hpp>
 
 namespace fts_share
@@ -70,11 +69,9 @@ void EncData::encrypt(const int64_t input_value,
 
     // encrypt the LUT query
     std::cout << "  Encrypting ..." << std::flush;
-    std::vector<int64_t> query;
-    for(size_t i=0 ; i<row_size ; i++){
-        query.push_back(input_value);
-    }
-    query.resize(slot_count);
+    // The input is replicated into both rows of the plaintext matrix,
+    // so that the computation server may pack table rows into either row.
+    std::vector<int64_t> query(slot_count, input_value);
 
     // Printing the matrix is a bit of a pain.
     auto print_matrix = [row_size](auto &matrix) {
@@ -162,11 +159,8 @@ void EncData::encrypt(const std::vector<int64_t>& input_values,
     
         //encrypt the LUT query
         std::cout << "  Encrypting ..." << std::flush;
-        std::vector<int64_t> query;
-        for(size_t i=0 ; i<row_size ; i++){
-            query.push_back(input_value);
-        }
-        query.resize(slot_count);
+        // replicated into both rows of the plaintext matrix
+        std::vector<int64_t> query(slot_count, input_value);
 
         seal::Plaintext plaintext_query;
         batch_encoder.encode(query, plaintext_query);
@@ -14,6 +14,7 @@ enum ControlCode_t : uint64_t
     /* Code for Request packet: 0x201-0x2FF */
     kControlCodeRequestNewKeys = 0x201,
     kControlCodeRequestDeleteKeys = 0x201,
+    kControlCodeRequestPing       = 0x202,
 
     /* Code for Data packet: 0x401-0x4FF */
     kControlCodeDataNewKeys     = 0x401,
@@ -24,6 +25,8 @@ enum ControlCode_t : uint64_t
     kControlCodeDataQueryID     = 0x406,
     kControlCodeDataResult      = 0x407,
     kControlCodeDataCsMidResult = 0x408,
+    kControlCodeDataCancelAck   = 0x409,
+    kControlCodeDataKeyCheck    = 0x40A,
 
     /* Code for Download packet: 0x801-0x8FF */
     kControlCodeDownloadNewKeys = 0x801,
@@ -36,6 +39,9 @@ enum ControlCode_t : uint64_t
     kControlCodeUpDownloadQuery       = 0x1005,
     kControlCodeUpDownloadResult      = 0x1006,
     kControlCodeUpDownloadCsMidResult = 0x1007,
+    kControlCodeUpDownloadResultPoll  = 0x1008,
+    kControlCodeUpDownloadCancel      = 0x1009,
+    kControlCodeUpDownloadKeyCheck    = 0x100A,
 };
 
 } /* namespace fts_share */
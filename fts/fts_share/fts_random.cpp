@@ -0,0 +1,205 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <algorithm>
+#include <stdsc/stdsc_log.hpp>
+#include <fts_share/fts_utility.hpp>
+#include <fts_share/fts_random.hpp>
+
+#define PHILOX_M0 (0xD2511F53U)
+#define PHILOX_M1 (0xCD9E8D57U)
+#define PHILOX_W0 (0x9E3779B9U)
+#define PHILOX_W1 (0xBB67AE85U)
+#define PHILOX_ROUNDS (10)
+#define PHILOX_LANES (16) // num of blocks generated at once
+
+namespace fts_share
+{
+
+/**
+ * Generate 'nblocks' blocks (4 words each) of Philox4x32-10.
+ * The lanes are kept in separate arrays, so that the round loop is vectorized.
+ */
+static void philox_blocks(const uint32_t key[2],
+                          const uint64_t stream,
+                          const uint64_t block,
+                          const size_t nblocks,
+                          uint32_t* out)
+{
+    uint32_t c0[PHILOX_LANES], c1[PHILOX_LANES], c2[PHILOX_LANES], c3[PHILOX_LANES];
+
+    for (size_t b=0; b<nblocks; b+=PHILOX_LANES) {
+        const size_t lanes = std::min<size_t>(PHILOX_LANES, nblocks - b);
+        
+        for (size_t i=0; i<PHILOX_LANES; ++i) {
+            uint64_t ctr = block + b + i;
+            c0[i] = static_cast<uint32_t>(ctr);
+            c1[i] = static_cast<uint32_t>(ctr >> 32);
+            c2[i] = static_cast<uint32_t>(stream);
+            c3[i] = static_cast<uint32_t>(stream >> 32);
+        }
+
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int r=0; r<PHILOX_ROUNDS; ++r) {
+            for (size_t i=0; i<PHILOX_LANES; ++i) {
+                uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0[i];
+                uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2[i];
+                uint32_t hi0 = static_cast<uint32_t>(p0 >> 32), lo0 = static_cast<uint32_t>(p0);
+                uint32_t hi1 = static_cast<uint32_t>(p1 >> 32), lo1 = static_cast<uint32_t>(p1);
+                c0[i] = hi1 ^ c1[i] ^ k0;
+                c1[i] = lo1;
+                c2[i] = hi0 ^ c3[i] ^ k1;
+                c3[i] = lo0;
+            }
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+
+        for (size_t i=0; i<lanes; ++i) {
+            out[(b + i) * 4 + 0] = c0[i];
+            out[(b + i) * 4 + 1] = c1[i];
+            out[(b + i) * 4 + 2] = c2[i];
+            out[(b + i) * 4 + 3] = c3[i];
+        }
+    }
+}
+
+struct SeedHolder
+{
+    std::mutex mutex;
+    bool initialized = false;
+    uint64_t seed = 0;
+};
+
+static SeedHolder& seed_holder()
+{
+    static SeedHolder holder;
+    return holder;
+}
+
+RandomGenerator::RandomGenerator(const uint64_t stream, const uint64_t seed)
+    : stream_(stream),
+      block_(0),
+      pos_(4)
+{
+    key_[0] = static_cast<uint32_t>(seed);
+    key_[1] = static_cast<uint32_t>(seed >> 32);
+}
+
+void RandomGenerator::refill(void)
+{
+    philox_blocks(key_, stream_, block_++, 1, buffer_);
+    pos_ = 0;
+}
+
+uint32_t RandomGenerator::next(void)
+{
+    if (pos_ >= 4) {
+        refill();
+    }
+    return buffer_[pos_++];
+}
+
+void RandomGenerator::fill(uint32_t* data, const size_t num)
+{
+    size_t i = 0;
+    while (i < num && pos_ < 4) {
+        data[i++] = buffer_[pos_++];
+    }
+
+    const size_t nblocks = (num - i) / 4;
+    if (nblocks > 0) {
+        philox_blocks(key_, stream_, block_, nblocks, data + i);
+        block_ += nblocks;
+        i += nblocks * 4;
+    }
+
+    while (i < num) {
+        data[i++] = next();
+    }
+}
+
+void RandomGenerator::fill_uniform(std::vector<int64_t>& vec, const size_t num,
+                                   const int64_t min, const int64_t max)
+{
+    std::vector<uint32_t> rnd(num);
+    fill(rnd.data(), num);
+    
+    const uint64_t range = static_cast<uint64_t>(max - min + 1);
+    vec.resize(num);
+    for (size_t i=0; i<num; ++i) {
+        vec[i] = min + static_cast<int64_t>((rnd[i] * range) >> 32);
+    }
+}
+
+std::vector<int64_t> RandomGenerator::permutation(const size_t num)
+{
+    std::vector<int64_t> perm(num);
+    for (size_t i=0; i<num; ++i) {
+        perm[i] = i;
+    }
+    if (num < 2) {
+        return perm;
+    }
+
+    // Fisher-Yates shuffle
+    std::vector<uint32_t> rnd(num);
+    fill(rnd.data(), num);
+    for (size_t i=num-1; i>0; --i) {
+        size_t j = (static_cast<uint64_t>(rnd[i]) * (i + 1)) >> 32;
+        std::swap(perm[i], perm[j]);
+    }
+    return perm;
+}
+
+void RandomGenerator::set_seed(const uint64_t seed)
+{
+    auto& holder = seed_holder();
+    std::lock_guard<std::mutex> lock(holder.mutex);
+    holder.seed = seed;
+    holder.initialized = true;
+    STDSC_LOG_INFO("Set random seed. (seed: %lu)", seed);
+}
+
+uint64_t RandomGenerator::get_seed(void)
+{
+    auto& holder = seed_holder();
+    std::lock_guard<std::mutex> lock(holder.mutex);
+    if (!holder.initialized) {
+        auto env = utility::getenv("FTS_RANDOM_SEED");
+        if (!env.empty() && utility::isdigit(env)) {
+            holder.seed = std::stoull(env);
+            STDSC_LOG_INFO("Set random seed from FTS_RANDOM_SEED. (seed: %lu)", holder.seed);
+        } else {
+            std::random_device rd;
+            holder.seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+        }
+        holder.initialized = true;
+    }
+    return holder.seed;
+}
+
+uint64_t RandomGenerator::new_stream_base(void)
+{
+    static std::atomic<uint64_t> counter(0);
+    return (counter++) << 32;
+}
+
+} /* namespace fts_share */
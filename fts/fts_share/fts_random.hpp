@@ -0,0 +1,108 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_RANDOM_HPP
+#define FTS_RANDOM_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace fts_share
+{
+
+/**
+ * @brief Counter-based random number generator (Philox4x32-10).
+ *
+ * The output is determined only by the seed, the stream number and the
+ * position in the stream, so each thread or each row can use its own
+ * stream without any synchronization.
+ */
+class RandomGenerator
+{
+public:
+    /**
+     * Constructor
+     * @param[in] stream stream number
+     * @param[in] seed   seed (default: process-wide seed)
+     */
+    explicit RandomGenerator(const uint64_t stream, const uint64_t seed = get_seed());
+    virtual ~RandomGenerator(void) = default;
+
+    /**
+     * Get next random number
+     * @return random number
+     */
+    uint32_t next(void);
+
+    /**
+     * Fill buffer with random numbers
+     * @param[out] data buffer
+     * @param[in] num   num of random numbers
+     */
+    void fill(uint32_t* data, const size_t num);
+
+    /**
+     * Fill vector with uniform random numbers in [min, max]
+     * @param[out] vec vector
+     * @param[in] num  num of random numbers
+     * @param[in] min  min value
+     * @param[in] max  max value
+     */
+    void fill_uniform(std::vector<int64_t>& vec, const size_t num,
+                      const int64_t min, const int64_t max);
+
+    /**
+     * Generate random permutation of [0, num)
+     * @param[in] num num of elements
+     * @return permutation
+     */
+    std::vector<int64_t> permutation(const size_t num);
+
+    /**
+     * Set process-wide seed. Used to reproduce results.
+     * @param[in] seed seed
+     */
+    static void set_seed(const uint64_t seed);
+
+    /**
+     * Get process-wide seed. The seed is taken from the environment variable
+     * FTS_RANDOM_SEED if set, otherwise from std::random_device.
+     * @return seed
+     */
+    static uint64_t get_seed(void);
+
+    /**
+     * Allocate new range of stream numbers for a query.
+     * The streams [base, base + 2^32) are reserved to the caller.
+     * @return base stream number
+     */
+    static uint64_t new_stream_base(void);
+
+private:
+    void refill(void);
+
+    uint32_t key_[2];
+    uint64_t stream_;
+    uint64_t block_;
+    uint32_t buffer_[4];
+    size_t pos_;
+};
+
+} /* namespace fts_share */
+
+#endif /* FTS_RANDOM_HPP */
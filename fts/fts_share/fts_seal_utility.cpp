@@ -88,6 +88,15 @@ namespace seal_utility
         return oss.str().size();
     }
 
+    std::vector<int> rotation_steps(const size_t poly_mod_degree)
+    {
+        std::vector<int> steps;
+        const size_t row_size = poly_mod_degree / 2;
+        for (size_t h=1; h<row_size; h*=2) {
+            steps.push_back(-static_cast<int>(h));
+        }
+        return steps;
+    }
 
 } /* namespace seal_utility */
 
@@ -47,6 +47,15 @@ namespace seal_utility
     template <>
     size_t stream_size<seal::EncryptionParameters>(const seal::EncryptionParameters& params);
 
+    /**
+     * Get steps of galois keys used by computation server. The rows are
+     * rotated only by -h (h: power of two less than row size) or by the
+     * composition of them, so the keys of other steps are not generated.
+     * @param[in] poly_mod_degree degree of polynomial modulus
+     * @return rotation steps
+     */
+    std::vector<int> rotation_steps(const size_t poly_mod_degree);
+
 } /* namespace seal_utility */
 
 } /* namespace fts_share */
@@ -0,0 +1,336 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <exception>
+#include <condition_variable>
+#include <stdsc/stdsc_log.hpp>
+#include <fts_share/fts_utility.hpp>
+#include <fts_share/fts_taskpool.hpp>
+
+#define TASKPOOL_WAIT_INTERVAL_MSEC (1)
+
+namespace fts_share
+{
+
+/*
+ * Iterations of one parallel_for. The iterations are claimed one by one
+ * from 'next', so that the rows of a large query are spread over all
+ * threads which take its tasks.
+ */
+struct TaskGroup
+{
+    TaskGroup(const int64_t begin, const int64_t end, const TaskPool::Func& func)
+        : next(begin), end(end), total(end - begin), func(func)
+    {}
+
+    void run(void)
+    {
+        int64_t i;
+        while ((i = next.fetch_add(1)) < end) {
+            if (!failed.load()) {
+                try {
+                    func(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }
+            if (done.fetch_add(1) + 1 == total) {
+                std::lock_guard<std::mutex> lock(mtx);
+                cond.notify_all();
+            }
+        }
+    }
+
+    bool is_done(void) const
+    {
+        return done.load() >= total;
+    }
+
+    std::atomic<int64_t> next;
+    const int64_t end;
+    const int64_t total;
+    const TaskPool::Func& func;
+    std::atomic<int64_t> done {0};
+    std::atomic<bool> failed {false};
+    std::exception_ptr error;
+    std::mutex mtx;
+    std::condition_variable cond;
+};
+
+struct TaskPool::Impl
+{
+    using Task = std::function<void(void)>;
+
+    struct Worker
+    {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    explicit Impl(const size_t num_threads)
+        : num_queued_(0),
+          next_worker_(0),
+          stop_(false)
+    {
+        size_t n = num_threads;
+        if (n == 0) {
+            n = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        for (size_t i=0; i<n; ++i) {
+            workers_.emplace_back(new Worker());
+        }
+        for (size_t i=0; i<n; ++i) {
+            threads_.emplace_back([this, i]() { worker_loop(i); });
+        }
+    }
+
+    ~Impl(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mtx_);
+            stop_ = true;
+        }
+        sleep_cond_.notify_all();
+        for (auto& th : threads_) {
+            th.join();
+        }
+    }
+
+    size_t num_threads(void) const
+    {
+        return workers_.size();
+    }
+
+    void parallel_for(const int64_t begin, const int64_t end, const Func& func)
+    {
+        const int64_t n = end - begin;
+        if (n <= 0) {
+            return;
+        }
+        if (n == 1) {
+            func(begin);
+            return;
+        }
+
+        auto group = std::make_shared<TaskGroup>(begin, end, func);
+
+        // The caller takes part in the iterations, so one task less is queued.
+        const size_t ntasks = std::min<size_t>(n - 1, workers_.size());
+        for (size_t t=0; t<ntasks; ++t) {
+            push([group]() { group->run(); });
+        }
+        group->run();
+
+        // Run queued tasks while the iterations taken by others finish.
+        while (!group->is_done()) {
+            if (!run_one()) {
+                std::unique_lock<std::mutex> lock(group->mtx);
+                group->cond.wait_for(lock,
+                                     std::chrono::milliseconds(TASKPOOL_WAIT_INTERVAL_MSEC),
+                                     [&group]() { return group->is_done(); });
+            }
+        }
+
+        if (group->error) {
+            std::rethrow_exception(group->error);
+        }
+    }
+
+private:
+    void push(Task&& task)
+    {
+        size_t idx;
+        if (current_pool() == this) {
+            idx = current_index();
+        } else {
+            idx = next_worker_.fetch_add(1) % workers_.size();
+        }
+        {
+            std::lock_guard<std::mutex> lock(workers_[idx]->mtx);
+            workers_[idx]->tasks.push_back(std::move(task));
+        }
+        num_queued_.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(sleep_mtx_);
+        }
+        sleep_cond_.notify_one();
+    }
+
+    bool pop_own(const size_t idx, Task& task)
+    {
+        auto& w = *workers_[idx];
+        std::lock_guard<std::mutex> lock(w.mtx);
+        if (w.tasks.empty()) {
+            return false;
+        }
+        task = std::move(w.tasks.back());
+        w.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(const size_t origin, Task& task)
+    {
+        const size_t n = workers_.size();
+        for (size_t k=0; k<n; ++k) {
+            auto& w = *workers_[(origin + k) % n];
+            std::lock_guard<std::mutex> lock(w.mtx);
+            if (!w.tasks.empty()) {
+                task = std::move(w.tasks.front());
+                w.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool run_one(void)
+    {
+        if (num_queued_.load() == 0) {
+            return false;
+        }
+
+        Task task;
+        bool found;
+        if (current_pool() == this) {
+            const size_t idx = current_index();
+            found = pop_own(idx, task) || steal(idx + 1, task);
+        } else {
+            found = steal(next_worker_.load() % workers_.size(), task);
+        }
+        if (!found) {
+            return false;
+        }
+        num_queued_.fetch_sub(1);
+        task();
+        return true;
+    }
+
+    void worker_loop(const size_t idx)
+    {
+        current_pool() = this;
+        current_index() = idx;
+
+        while (true) {
+            if (run_one()) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mtx_);
+            sleep_cond_.wait(lock, [this]() {
+                return stop_ || num_queued_.load() > 0;
+            });
+            if (stop_ && num_queued_.load() == 0) {
+                break;
+            }
+        }
+    }
+
+    static const Impl*& current_pool(void)
+    {
+        static thread_local const Impl* pool = nullptr;
+        return pool;
+    }
+
+    static size_t& current_index(void)
+    {
+        static thread_local size_t index = 0;
+        return index;
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> num_queued_;
+    std::atomic<size_t> next_worker_;
+    std::mutex sleep_mtx_;
+    std::condition_variable sleep_cond_;
+    bool stop_;
+};
+
+TaskPool::TaskPool(const size_t num_threads)
+    : pimpl_(new Impl(num_threads))
+{}
+
+TaskPool::~TaskPool(void)
+{}
+
+size_t TaskPool::num_threads(void) const
+{
+    return pimpl_->num_threads();
+}
+
+void TaskPool::parallel_for(const int64_t begin, const int64_t end, const Func& func)
+{
+    pimpl_->parallel_for(begin, end, func);
+}
+
+struct SharedPoolHolder
+{
+    std::mutex mutex;
+    bool configured = false;
+    size_t num_threads = 0;
+    std::unique_ptr<TaskPool> pool;
+};
+
+static SharedPoolHolder& shared_pool_holder()
+{
+    static SharedPoolHolder holder;
+    return holder;
+}
+
+void TaskPool::set_shared_threads(const size_t num_threads)
+{
+    auto& holder = shared_pool_holder();
+    std::lock_guard<std::mutex> lock(holder.mutex);
+    if (holder.pool) {
+        STDSC_LOG_WARN("Task pool is already running. (threads: %lu)",
+                       holder.pool->num_threads());
+        return;
+    }
+    holder.num_threads = num_threads;
+    holder.configured = true;
+}
+
+TaskPool& TaskPool::shared(void)
+{
+    auto& holder = shared_pool_holder();
+    std::lock_guard<std::mutex> lock(holder.mutex);
+    if (!holder.pool) {
+        if (!holder.configured) {
+            auto env = utility::getenv("FTS_NUM_THREADS");
+            if (!env.empty() && utility::isdigit(env)) {
+                holder.num_threads = std::stoul(env);
+            }
+        }
+        holder.pool.reset(new TaskPool(holder.num_threads));
+        STDSC_LOG_INFO("Start task pool. (threads: %lu, cores: %u)",
+                       holder.pool->num_threads(),
+                       std::thread::hardware_concurrency());
+    }
+    return *holder.pool;
+}
+
+} /* namespace fts_share */
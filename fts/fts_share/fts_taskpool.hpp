@@ -0,0 +1,87 @@
+/*
+ * Copyright 2018 Yamana Laboratory, Waseda University
+ * Supported by JST CREST Grant Number JPMJCR1503, Japan.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE‐2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FTS_TASKPOOL_HPP
+#define FTS_TASKPOOL_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <functional>
+
+namespace fts_share
+{
+
+/**
+ * @brief Work-stealing task pool.
+ *
+ * Each worker has its own deque. A worker pops tasks from the back of its
+ * own deque and steals from the front of the others when it runs out.
+ * The caller of parallel_for() runs the iterations as well and keeps
+ * running queued tasks while it waits, so parallel_for() may be called
+ * from any thread, including the workers, without oversubscribing cores.
+ */
+class TaskPool
+{
+public:
+    using Func = std::function<void(int64_t)>;
+
+    /**
+     * Constructor
+     * @param[in] num_threads num of worker threads (0: num of cores)
+     */
+    explicit TaskPool(const size_t num_threads = 0);
+    virtual ~TaskPool(void);
+
+    /**
+     * Get num of worker threads
+     * @return num of worker threads
+     */
+    size_t num_threads(void) const;
+
+    /**
+     * Call func(i) for each i in [begin, end) in parallel and wait for them.
+     * The first exception thrown by func is rethrown after all iterations end.
+     * @param[in] begin first index
+     * @param[in] end   last index (exclusive)
+     * @param[in] func  function
+     */
+    void parallel_for(const int64_t begin, const int64_t end, const Func& func);
+
+    /**
+     * Set num of worker threads of the process-wide pool.
+     * Must be called before the first call of shared().
+     * @param[in] num_threads num of worker threads (0: num of cores)
+     */
+    static void set_shared_threads(const size_t num_threads);
+
+    /**
+     * Get process-wide pool. The num of worker threads is taken from
+     * set_shared_threads() if called, otherwise from the environment
+     * variable FTS_NUM_THREADS if set, otherwise the num of cores.
+     * @return process-wide pool
+     */
+    static TaskPool& shared(void);
+
+private:
+    struct Impl;
+    std::shared_ptr<Impl> pimpl_;
+};
+
+} /* namespace fts_share */
+
+#endif /* FTS_TASKPOOL_HPP */
@@ -25,6 +25,7 @@ std::ostream& operator<<(std::ostream& os, const User2CsParam& param)
     auto i32_func_no = static_cast<int32_t>(param.func_no);
     os << param.key_id  << std::endl;
     os << i32_func_no << std::endl;
+    os << param.deadline_msec << std::endl;
     return os;
 }
 
@@ -33,8 +34,23 @@ std::istream& operator>>(std::istream& is, User2CsParam& param)
     int32_t i32_func_no;
     is >> param.key_id;
     is >> i32_func_no;
+    is >> param.deadline_msec;
     param.func_no = static_cast<FuncNo_t>(i32_func_no);
     return is;
 }
+
+std::ostream& operator<<(std::ostream& os, const User2CsPollParam& param)
+{
+    os << param.query_id     << std::endl;
+    os << param.timeout_msec << std::endl;
+    return os;
+}
+
+std::istream& operator>>(std::istream& is, User2CsPollParam& param)
+{
+    is >> param.query_id;
+    is >> param.timeout_msec;
+    return is;
+}
     
 } /* namespace fts_share */
@@ -31,11 +31,24 @@ struct User2CsParam
 {
     int32_t  key_id;
     FuncNo_t func_no;
+    uint32_t deadline_msec = 0; // deadline from submission (0: none)
 };
 
 std::ostream& operator<<(std::ostream& os, const User2CsParam& param);
 std::istream& operator>>(std::istream& is, User2CsParam& param);
 
+/**
+ * @brief This class is used to hold the parameters to poll results on cs.
+ */
+struct User2CsPollParam
+{
+    int32_t  query_id;
+    uint32_t timeout_msec; // 0: returns immediately if not ready
+};
+
+std::ostream& operator<<(std::ostream& os, const User2CsPollParam& param);
+std::istream& operator>>(std::istream& is, User2CsPollParam& param);
+
 } /* namespace fts_share */
 
 #endif /* FTS_USER2CSPARAM_HPP */
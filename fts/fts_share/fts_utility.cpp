@@ -23,6 +23,8 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm> // std::all_of
+#include <atomic>    // std::atomic
+#include <random>    // std::random_device
 #include <dirent.h>  // scandir
 #include <string.h>  // strcmp
 #include <stdsc/stdsc_exception.hpp>
@@ -124,8 +126,18 @@ void split(const std::string& str, const std::string& delims,
 
 int32_t gen_uuid(void)
 {
-    std::srand(std::time(nullptr));
-    return std::rand();
+    // The counter is mixed by a bijection on 31 bits, so that IDs are
+    // not sequential and never collide until 2^31 IDs are generated.
+    static std::atomic<uint32_t> counter {std::random_device{}()};
+    static const uint32_t mask = std::random_device{}();
+    constexpr uint32_t bits = 0x7fffffff;
+    
+    uint32_t x = (counter++ ^ mask) & bits;
+    x = (x * 0x2545f491u) & bits;
+    x ^= x >> 15;
+    x = (x * 0x6b43a9b5u) & bits;
+    x ^= x >> 13;
+    return static_cast<int32_t>(x);
 }
 
 std::string trim_string(const std::string& str, const std::string& whitespace)
@@ -36,6 +36,9 @@ bool isdigit(const std::string& str);
 std::string getenv(const char* env_var);
 void split(const std::string& str, const std::string& delims,
            std::vector<std::string>& vec_str);
+/**
+ * Generate ID which is unique in this process (non-negative).
+ */
 int32_t gen_uuid(void);
 std::string trim_string(const std::string& str, const std::string& whitespace = " \t");
 std::vector<std::string> get_filelist(const std::string& dir, const std::string& ext = "");
@@ -2,6 +2,10 @@
 #include <fstream>
 #include <vector>
 #include <cstring>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
 #include <stdsc/stdsc_client.hpp>
 #include <stdsc/stdsc_buffer.hpp>
 #include <stdsc/stdsc_packet.hpp>
@@ -29,11 +33,14 @@ struct ResultCallback
 struct CSClient::Impl
 {
     Impl(const char* host, const char* port,
-         const seal::EncryptionParameters& enc_params)
+         const seal::EncryptionParameters& enc_params,
+         const uint32_t max_query_retries)
         : host_(host),
           port_(port),
           enc_params_(enc_params),
-          client_()
+          max_query_retries_(max_query_retries),
+          client_(),
+          rng_(std::random_device()())
     {
     }
 
@@ -54,10 +61,38 @@ struct CSClient::Impl
     }
 
     int32_t send_query(const int32_t key_id, const int32_t func_no,
-                       const fts_share::EncData& enc_inputs)
+                       const fts_share::EncData& enc_inputs,
+                       const uint32_t deadline_msec)
+    {
+        for (uint32_t attempt = 0; ; ++attempt) {
+            fts_share::Cs2UserParam cs2userparam;
+            auto query_id = send_query_once(key_id, func_no, enc_inputs, deadline_msec, cs2userparam);
+            if (cs2userparam.result != fts_share::kCsCalcResultRejected) {
+                return query_id;
+            }
+            if (attempt >= max_query_retries_) {
+                STDSC_LOG_WARN("Query is rejected by overload %u times, gave up.", attempt + 1);
+                return -1;
+            }
+
+            // Wait the time told by server, plus the jittered exponential
+            // backoff so that rejected users do not retry all at once.
+            const uint32_t backoff = std::min<uint32_t>(FTS_MAX_RETRY_AFTER_MSEC,
+                                                        FTS_QUERY_RETRY_BASE_MSEC << std::min<uint32_t>(attempt, 16));
+            std::uniform_int_distribution<uint32_t> jitter(0, backoff);
+            const uint32_t delay = cs2userparam.retry_after_msec + jitter(rng_);
+            STDSC_LOG_INFO("Query is rejected by overload, retry after %u msec.", delay);
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        }
+    }
+
+    int32_t send_query_once(const int32_t key_id, const int32_t func_no,
+                            const fts_share::EncData& enc_inputs,
+                            const uint32_t deadline_msec,
+                            fts_share::Cs2UserParam& cs2userparam)
     {
         fts_share::PlainData<fts_share::User2CsParam> splaindata;
-        fts_share::User2CsParam user2csparam {key_id, static_cast<fts_share::FuncNo_t>(func_no)};
+        fts_share::User2CsParam user2csparam {key_id, static_cast<fts_share::FuncNo_t>(func_no), deadline_msec};
         splaindata.push(user2csparam);
 
         auto sz = (splaindata.stream_size()
@@ -76,16 +111,22 @@ struct CSClient::Impl
 
         stdsc::BufferStream rbuffstream(rbuffer);
         std::iostream rstream(&rbuffstream);
+        fts_share::PlainData<fts_share::Cs2UserParam> rplaindata_status;
+        rplaindata_status.load_from_stream(rstream);
+        cs2userparam = rplaindata_status.data();
+        
         fts_share::PlainData<int32_t> rplaindata;
         rplaindata.load_from_stream(rstream);
 
         return rplaindata.data();
     }
 
-    void recv_results(const int32_t query_id, bool& status, fts_share::EncData& enc_result)
+    bool poll_results(const int32_t query_id, const uint32_t timeout_msec,
+                      bool& status, fts_share::EncData& enc_result)
     {
-        fts_share::PlainData<int32_t> splaindata;
-        splaindata.push(query_id);
+        fts_share::PlainData<fts_share::User2CsPollParam> splaindata;
+        fts_share::User2CsPollParam pollparam {query_id, timeout_msec};
+        splaindata.push(pollparam);
 
         auto sz = (splaindata.stream_size()
                    + fts_share::seal_utility::stream_size(enc_params_));
@@ -97,7 +138,7 @@ struct CSClient::Impl
 
         stdsc::Buffer* sbuffer = &sbuffstream;
         stdsc::Buffer rbuffer;
-        client_.send_recv_data_blocking(fts_share::kControlCodeUpDownloadResult, *sbuffer, rbuffer);
+        client_.send_recv_data_blocking(fts_share::kControlCodeUpDownloadResultPoll, *sbuffer, rbuffer);
 
         stdsc::BufferStream rbuffstream(rbuffer);
         std::iostream rstream(&rbuffstream);
@@ -105,6 +146,13 @@ struct CSClient::Impl
         fts_share::PlainData<fts_share::Cs2UserParam> rplaindata;
         rplaindata.load_from_stream(rstream);
         auto& cs2userparam = rplaindata.data();
+        if (cs2userparam.result == fts_share::kCsCalcResultPending) {
+            return false;
+        }
+        if (cs2userparam.result == fts_share::kCsCalcResultNotFound) {
+            STDSC_LOG_WARN("Query #%d is not found on server. "
+                           "It may have been cancelled or its result deleted.", query_id);
+        }
         status = cs2userparam.result == fts_share::kCsCalcResultSuccess;
 
         if (status) {
@@ -113,6 +161,39 @@ struct CSClient::Impl
             fts_share::seal_utility::write_to_file("result.txt", enc_result.data());
 #endif
         }
+        return true;
+    }
+
+    void recv_results(const int32_t query_id, bool& status, fts_share::EncData& enc_result)
+    {
+        // Long-poll so that no server thread is held until the query finishes.
+        // Polling ends with failure if the query is not found on server.
+        while (!poll_results(query_id, FTS_DEFAULT_RESULT_POLL_MSEC, status, enc_result)) {
+            STDSC_LOG_TRACE("Query #%d is pending.", query_id);
+        }
+    }
+
+    bool cancel_query(const int32_t query_id)
+    {
+        fts_share::PlainData<int32_t> splaindata;
+        splaindata.push(query_id);
+
+        auto sz = splaindata.stream_size();
+        stdsc::BufferStream sbuffstream(sz);
+        std::iostream stream(&sbuffstream);
+
+        splaindata.save_to_stream(stream);
+
+        stdsc::Buffer* sbuffer = &sbuffstream;
+        stdsc::Buffer rbuffer;
+        client_.send_recv_data_blocking(fts_share::kControlCodeUpDownloadCancel, *sbuffer, rbuffer);
+
+        stdsc::BufferStream rbuffstream(rbuffer);
+        std::iostream rstream(&rbuffstream);
+        fts_share::PlainData<int32_t> rplaindata;
+        rplaindata.load_from_stream(rstream);
+
+        return rplaindata.data() != 0;
     }
 
     void wait(const int32_t query_id) const
@@ -126,13 +207,16 @@ struct CSClient::Impl
     const char* host_;
     const char* port_;
     const seal::EncryptionParameters& enc_params_;
+    const uint32_t max_query_retries_;
     stdsc::Client client_;
+    std::mt19937 rng_;
     std::unordered_map<int32_t, ResultCallback> cbmap_;
 };
 
 CSClient::CSClient(const char* host, const char* port,
-                   const seal::EncryptionParameters& enc_params)
-    : pimpl_(new Impl(host, port, enc_params))
+                   const seal::EncryptionParameters& enc_params,
+                   const uint32_t max_query_retries)
+    : pimpl_(new Impl(host, port, enc_params, max_query_retries))
 {
 }
 
@@ -150,11 +234,12 @@ void CSClient::disconnect(void)
 }
 
 int32_t CSClient::send_query(const int32_t key_id, const int32_t func_no,
-                             const fts_share::EncData& enc_inputs) const
+                             const fts_share::EncData& enc_inputs,
+                             const uint32_t deadline_msec) const
 {
-    STDSC_LOG_INFO("Send query: sending query to computation server. (key_id: %d, func_no:%d)",
-                   key_id, func_no);
-    auto query_id = pimpl_->send_query(key_id, func_no, enc_inputs);
+    STDSC_LOG_INFO("Send query: sending query to computation server. (key_id: %d, func_no:%d, deadline_msec:%u)",
+                   key_id, func_no, deadline_msec);
+    auto query_id = pimpl_->send_query(key_id, func_no, enc_inputs, deadline_msec);
     STDSC_LOG_INFO("Send query: received query ID (#%d)", query_id);
     return query_id;
 }
@@ -162,11 +247,14 @@ int32_t CSClient::send_query(const int32_t key_id, const int32_t func_no,
 int32_t CSClient::send_query(const int32_t key_id, const int32_t func_no,
                              const fts_share::EncData& enc_inputs,
                              cbfunc_t cbfunc,
-                             void* cbfunc_args) const
+                             void* cbfunc_args,
+                             const uint32_t deadline_msec) const
 {
-    int32_t query_id = pimpl_->send_query(key_id, func_no, enc_inputs);
-    STDSC_LOG_INFO("Set callback function for query #%d", query_id);
-    set_callback(query_id, cbfunc, cbfunc_args);
+    int32_t query_id = pimpl_->send_query(key_id, func_no, enc_inputs, deadline_msec);
+    if (query_id >= 0) {
+        STDSC_LOG_INFO("Set callback function for query #%d", query_id);
+        set_callback(query_id, cbfunc, cbfunc_args);
+    }
     return query_id;
 }
 
@@ -176,6 +264,18 @@ void CSClient::recv_results(const int32_t query_id, bool& status, fts_share::Enc
     pimpl_->recv_results(query_id, status, enc_result);
 }
 
+bool CSClient::poll_results(const int32_t query_id, const uint32_t timeout_msec,
+                            bool& status, fts_share::EncData& enc_result) const
+{
+    return pimpl_->poll_results(query_id, timeout_msec, status, enc_result);
+}
+
+bool CSClient::cancel_query(const int32_t query_id) const
+{
+    STDSC_LOG_INFO("Cancel query #%d.", query_id);
+    return pimpl_->cancel_query(query_id);
+}
+
 void CSClient::set_callback(const int32_t query_id, cbfunc_t func, void* args) const
 {
     ResultCallback rcb;
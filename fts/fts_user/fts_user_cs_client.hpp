@@ -41,9 +41,11 @@ public:
      * @param[in] host hostname
      * @param[in] port port number
      * @param[in] enc_params parameters for seal
+     * @param[in] max_query_retries max number of retries when query is rejected by overload
      */
     CSClient(const char* host, const char* port,
-             const seal::EncryptionParameters& enc_params);
+             const seal::EncryptionParameters& enc_params,
+             const uint32_t max_query_retries = FTS_DEFAULT_QUERY_RETRIES);
     virtual ~CSClient(void) = default;
 
     /**
@@ -63,10 +65,12 @@ public:
      * @param[in] key_id key ID
      * @param[in] func_no function number
      * @param[in] enc_input encrypted input values (1 or 2)
-     * @return queryID
+     * @param[in] deadline_msec deadline of query (msec, 0: none)
+     * @return queryID (-1: failed or rejected by overload after retries)
      */
     int32_t send_query(const int32_t key_id, const int32_t func_no,
-                       const fts_share::EncData& enc_inputs) const;
+                       const fts_share::EncData& enc_inputs,
+                       const uint32_t deadline_msec = 0) const;
 
     /**
      * Send query
@@ -75,12 +79,14 @@ public:
      * @param[in] enc_input encrypted input values (1 or 2)
      * @param[in] cbfunc callback function
      * @param[in] cbfunc_args arguments for callback function
+     * @param[in] deadline_msec deadline of query (msec, 0: none)
      * @return queryID
      */
     int32_t send_query(const int32_t key_id, const int32_t func_no,
                        const fts_share::EncData& enc_inputs,
                        cbfunc_t cbfunc,
-                       void* cbfunc_args) const;
+                       void* cbfunc_args,
+                       const uint32_t deadline_msec = 0) const;
     
     /**
      * Receive results
@@ -90,6 +96,25 @@ public:
      */
     void recv_results(const int32_t query_id, bool& status, fts_share::EncData& enc_result) const;
 
+    /**
+     * Poll results
+     * @param[in] query_id     query ID
+     * @param[in] timeout_msec time to wait for results on server (msec, 0: no wait)
+     * @param[out] status      calcuration status
+     * @param[out] enc_result  encrypted result
+     * @return true if results are received or query is not found on server
+     *         (status is false), false if query is still pending
+     */
+    bool poll_results(const int32_t query_id, const uint32_t timeout_msec,
+                      bool& status, fts_share::EncData& enc_result) const;
+
+    /**
+     * Cancel query. The computation is dropped and the result is discarded.
+     * @param[in] query_id query ID
+     * @return false if query is not found on server
+     */
+    bool cancel_query(const int32_t query_id) const;
+
     /**
      * Set callback functions
      * @param[in] query_id queryID
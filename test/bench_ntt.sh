@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# Compares the elapsed time of computationB between the normal and NTT
+# evaluation modes for one input LUTs of k rows.
+#   ./bench_ntt.sh [k ...]
+
+PWD=`pwd`
+TOPDIR=${PWD}/..
+BINDIR=${TOPDIR}/build/demo
+WORKDIR=${PWD}/bench_ntt
+
+ROW_SIZE=4096
+KLIST="$@"
+if [ -z "${KLIST}" ]; then
+    KLIST="1 2 5 10 20 50 100 200"
+fi
+
+mkdir -p ${WORKDIR}
+
+IS_EXIST_DEC=`ps auxww | grep ./dec | grep -v grep`
+if [ -z "${IS_EXIST_DEC}" ]; then
+    echo "Start decryptor"
+    (cd ${BINDIR}/dec  && ./dec 2>&1 > /dev/null &)
+fi
+pkill -x cs
+
+echo "k, normal (msec), ntt (msec)"
+for k in ${KLIST}; do
+    LUTDIR=${WORKDIR}/lut_${k}
+    mkdir -p ${LUTDIR}
+    python ${PWD}/sample_LUT/make_sample_lut_one.py $((k * ROW_SIZE)) > ${LUTDIR}/sample_lut_one.csv
+
+    LINE="${k}"
+    for mode in normal ntt; do
+        LOGFILE=${WORKDIR}/cs_${k}_${mode}.log
+        (cd ${BINDIR}/cs && ./cs -d ${LUTDIR} -e ${mode} > ${LOGFILE} 2>&1 &)
+        sleep 3
+        (cd ${BINDIR}/user && ./user 1 > /dev/null 2>&1)
+        pkill -x cs
+        sleep 1
+
+        # The elapsed time of the kernel is logged with the mode and rows.
+        MSEC=`grep "computationB of query .*(mode: ${mode}," ${LOGFILE} | tail -n1 | sed -e 's/.*, \([0-9]*\) msec.*/\1/'`
+        LINE="${LINE}, ${MSEC}"
+    done
+    echo ${LINE}
+done
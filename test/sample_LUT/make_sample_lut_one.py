@@ -1,4 +1,8 @@
+import sys
+
 n = 256
+if len(sys.argv) > 1:
+    n = int(sys.argv[1])
 
 print("%d, %d" % (1, n))
 for i in range(n):